@@ -0,0 +1,24 @@
+#include "Ast.h"
+
+Ast Ast::withStringsOf(const Ast& other)
+{
+    // Interned in the same order, each string gets the same id
+    Ast ast;
+    for (const auto& text : other.strings)
+    {
+        ast.intern(text);
+    }
+    return ast;
+}
+
+NameId Ast::intern(std::string_view text)
+{
+    auto it = ids.find(text);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+    const auto id = static_cast<NameId>(strings.size());
+    ids.emplace(strings.emplace_back(text), id);
+    return id;
+}
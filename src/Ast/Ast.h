@@ -0,0 +1,276 @@
+#pragma once
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Evaluator/EvaluatorError.h"
+#include "../Expression/Expression.h"
+#include "../Statement/Statement.h"
+#include "NodeId.h"
+
+// Owns the AST of a program as flat arrays. Nodes are stored by value, one vector per node type,
+// and refer to their children by 32-bit NodeIds; the children of a block or call, and the
+// parameters of a function, are runs of a shared list of ids. Names and literal text are interned
+// once into a table and referred to by NameId. A tree is thus a few large allocations, walked by
+// indexing, and freed with the Ast all at once.
+//
+// Nodes are appended as they are built, children first, and never removed. Adding a node may move
+// the others of its type, so a reference to a node must not be held across adding one. Nodes are
+// only annotated in place once the tree is complete, by the Resolver and the Evaluator, which is
+// why their annotations are mutable.
+class Ast
+{
+   public:
+    Ast() = default;
+
+    Ast(const Ast&)            = delete;
+    Ast& operator=(const Ast&) = delete;
+
+    Ast(Ast&&)            = default;
+    Ast& operator=(Ast&&) = default;
+
+    // An empty Ast with the strings of `other` interned under the same ids, for a program rebuilt
+    // from the one in `other`
+    static Ast withStringsOf(const Ast& other);
+
+    template <typename Node>
+    typename Node::Id add(Node node)
+    {
+        auto& vector = nodes<Node>();
+        if (vector.size() >= Node::Id::capacity)
+        {
+            throw EvaluatorError("Too many nodes of one kind in the program.");
+        }
+        vector.push_back(std::move(node));
+        return typename Node::Id(Node::kind, static_cast<uint32_t>(vector.size() - 1));
+    }
+
+    // `id` must refer to a node of type `Node`
+    template <typename Node>
+    const Node& get(typename Node::Id id) const
+    {
+        return nodes<Node>()[id.index()];
+    }
+
+    IdList<ExpressionId> add(std::span<const ExpressionId> list)
+    {
+        return append(list, expressionLists);
+    }
+    IdList<StatementId> add(std::span<const StatementId> list)
+    {
+        return append(list, statementLists);
+    }
+    IdList<NameId> add(std::span<const NameId> list) { return append(list, nameLists); }
+
+    std::span<const ExpressionId> get(IdList<ExpressionId> list) const
+    {
+        return view(list, expressionLists);
+    }
+    std::span<const StatementId> get(IdList<StatementId> list) const
+    {
+        return view(list, statementLists);
+    }
+    std::span<const NameId> get(IdList<NameId> list) const { return view(list, nameLists); }
+
+    NameId             intern(std::string_view text);
+    const std::string& getString(NameId id) const { return strings[static_cast<uint32_t>(id)]; }
+
+    // The top-level statements of the program
+    std::span<const StatementId> getStatements() const { return get(statements); }
+    void setStatements(std::span<const StatementId> list) { statements = add(list); }
+
+    // Keeps a fallback of a VariableLocation, which refers to it by address
+    const VariableLocation* addFallback(const VariableLocation& fallback)
+    {
+        return &fallbacks.emplace_back(fallback);
+    }
+
+   private:
+    template <typename... Nodes>
+    using Vectors = std::tuple<std::vector<Nodes>...>;
+
+    Vectors<LiteralExpression,
+            GroupingExpression,
+            UnaryExpression,
+            BinaryExpression,
+            VariableExpression,
+            AssignmentExpression,
+            LogicalExpression,
+            CallExpression,
+            CompoundAssignmentExpression,
+            ComparisonExpression,
+            ExpressionStatement,
+            PrintStatement,
+            VariableStatement,
+            BlockStatement,
+            IfStatement,
+            WhileStatement,
+            ForStatement,
+            FunctionDefinitionStatement,
+            ReturnStatement>
+        vectors;
+
+    std::vector<ExpressionId> expressionLists;
+    std::vector<StatementId>  statementLists;
+    std::vector<NameId>       nameLists;
+
+    IdList<StatementId> statements;
+
+    // A deque keeps the strings in place as it grows, so the views keying `ids` stay valid
+    std::deque<std::string>                      strings;
+    std::unordered_map<std::string_view, NameId> ids;
+
+    std::deque<VariableLocation> fallbacks;
+
+    template <typename Node>
+    std::vector<Node>& nodes()
+    {
+        return std::get<std::vector<Node>>(vectors);
+    }
+
+    template <typename Node>
+    const std::vector<Node>& nodes() const
+    {
+        return std::get<std::vector<Node>>(vectors);
+    }
+
+    template <typename Id>
+    static IdList<Id> append(std::span<const Id> list, std::vector<Id>& lists)
+    {
+        const IdList<Id> appended{static_cast<uint32_t>(lists.size()),
+                                  static_cast<uint32_t>(list.size())};
+        lists.insert(lists.end(), list.begin(), list.end());
+        return appended;
+    }
+
+    template <typename Id>
+    static std::span<const Id> view(IdList<Id> list, const std::vector<Id>& lists)
+    {
+        return {lists.data() + list.first, list.size};
+    }
+};
+
+// Calls the method of `visitor` for the type of the node `id` refers to, chosen by a switch on the
+// kind the id carries. The method is named through the visitor's own class, so it is called
+// directly rather than through the vtable and can be inlined. The node is taken from `nodes`, an
+// Ast or anything else with the same get method.
+template <typename Visitor, typename Nodes>
+auto visit(Visitor& visitor, const Nodes& nodes, ExpressionId id, Environment* env = nullptr)
+{
+    switch (id.kind())
+    {
+        case ExpressionKind::Literal:
+            return visitor.Visitor::visitLiteralExpression(
+                nodes.template get<LiteralExpression>(id), env);
+        case ExpressionKind::Grouping:
+            return visitor.Visitor::visitGroupingExpression(
+                nodes.template get<GroupingExpression>(id), env);
+        case ExpressionKind::Unary:
+            return visitor.Visitor::visitUnaryExpression(nodes.template get<UnaryExpression>(id),
+                                                         env);
+        case ExpressionKind::Binary:
+            return visitor.Visitor::visitBinaryExpression(
+                nodes.template get<BinaryExpression>(id), env);
+        case ExpressionKind::Variable:
+            return visitor.Visitor::visitVariableExpression(
+                nodes.template get<VariableExpression>(id), env);
+        case ExpressionKind::Assignment:
+            return visitor.Visitor::visitAssignmentExpression(
+                nodes.template get<AssignmentExpression>(id), env);
+        case ExpressionKind::Logical:
+            return visitor.Visitor::visitLogicalExpression(
+                nodes.template get<LogicalExpression>(id), env);
+        case ExpressionKind::Call:
+            return visitor.Visitor::visitCallExpression(nodes.template get<CallExpression>(id),
+                                                        env);
+        case ExpressionKind::CompoundAssignment:
+            return visitor.Visitor::visitCompoundAssignmentExpression(
+                nodes.template get<CompoundAssignmentExpression>(id), env);
+        case ExpressionKind::Comparison:
+            return visitor.Visitor::visitComparisonExpression(
+                nodes.template get<ComparisonExpression>(id), env);
+    }
+    std::unreachable();
+}
+
+// Same as above, for statements
+template <typename Visitor, typename Nodes>
+auto visit(Visitor& visitor, const Nodes& nodes, StatementId id, Environment* env = nullptr)
+{
+    switch (id.kind())
+    {
+        case StatementKind::Expression:
+            return visitor.Visitor::visitExpressionStatement(
+                nodes.template get<ExpressionStatement>(id), env);
+        case StatementKind::Print:
+            return visitor.Visitor::visitPrintStatement(nodes.template get<PrintStatement>(id),
+                                                        env);
+        case StatementKind::Variable:
+            return visitor.Visitor::visitVariableStatement(
+                nodes.template get<VariableStatement>(id), env);
+        case StatementKind::Block:
+            return visitor.Visitor::visitBlockStatement(nodes.template get<BlockStatement>(id),
+                                                        env);
+        case StatementKind::If:
+            return visitor.Visitor::visitIfStatement(nodes.template get<IfStatement>(id), env);
+        case StatementKind::While:
+            return visitor.Visitor::visitWhileStatement(nodes.template get<WhileStatement>(id),
+                                                        env);
+        case StatementKind::For:
+            return visitor.Visitor::visitForStatement(nodes.template get<ForStatement>(id), env);
+        case StatementKind::FunctionDefinition:
+            return visitor.Visitor::visitFunctionDefinitionStatement(
+                nodes.template get<FunctionDefinitionStatement>(id), env);
+        case StatementKind::Return:
+            return visitor.Visitor::visitReturnStatement(nodes.template get<ReturnStatement>(id),
+                                                         env);
+    }
+    std::unreachable();
+}
+
+// Calls `f` with each name `stmnt` declares in the scope it runs in: its own, or one declared by
+// the body of an `if` or loop that is not a block
+template <typename F>
+void forEachDeclaredName(const Ast& ast, StatementId stmnt, F&& f)
+{
+    switch (stmnt.kind())
+    {
+        case StatementKind::Variable:
+            f(ast.get<VariableStatement>(stmnt).getName());
+            break;
+        case StatementKind::FunctionDefinition:
+            f(ast.get<FunctionDefinitionStatement>(stmnt).getName());
+            break;
+        case StatementKind::If:
+        {
+            const auto& ifStatement = ast.get<IfStatement>(stmnt);
+            forEachDeclaredName(ast, ifStatement.getThenBranch(), f);
+            if (ifStatement.getElseBranch())
+            {
+                forEachDeclaredName(ast, ifStatement.getElseBranch(), f);
+            }
+            break;
+        }
+        case StatementKind::While:
+            forEachDeclaredName(ast, ast.get<WhileStatement>(stmnt).getBody(), f);
+            break;
+        case StatementKind::For:
+        {
+            const auto& forStatement = ast.get<ForStatement>(stmnt);
+            if (forStatement.getInitializer())
+            {
+                forEachDeclaredName(ast, forStatement.getInitializer(), f);
+            }
+            forEachDeclaredName(ast, forStatement.getBody(), f);
+            break;
+        }
+        default:
+            break;
+    }
+}
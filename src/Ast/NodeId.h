@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+
+// Concrete types of nodes, see Expression.h and Statement.h
+enum class ExpressionKind : uint8_t;
+enum class StatementKind : uint8_t;
+
+// Refers to a node of an Ast: its kind, which selects the vector the node is stored in, and its
+// index in that vector, packed in 32 bits. A default constructed id refers to no node, and stands
+// for a missing optional child.
+template <typename Kind>
+class NodeId
+{
+   public:
+    // Nodes of one kind an Ast can hold
+    static constexpr uint32_t capacity = (1u << 28) - 1;
+
+    NodeId() = default;
+    NodeId(Kind kind, uint32_t index) : bits(static_cast<uint32_t>(kind) << indexBits | index) {}
+
+    Kind     kind() const { return static_cast<Kind>(bits >> indexBits); }
+    uint32_t index() const { return bits & capacity; }
+
+    explicit operator bool() const { return bits != none; }
+    bool     operator==(const NodeId&) const = default;
+
+   private:
+    static constexpr uint32_t indexBits = 28;
+    static constexpr uint32_t none      = UINT32_MAX;
+
+    uint32_t bits = none;
+};
+
+using ExpressionId = NodeId<ExpressionKind>;
+using StatementId  = NodeId<StatementKind>;
+
+// Refers to a string interned in an Ast: a name, or the source text of a literal. Two ids of the
+// same Ast are equal exactly when their strings are.
+enum class NameId : uint32_t
+{
+};
+
+// Consecutive entries of one of an Ast's lists, such as the arguments of a call
+template <typename Id>
+struct IdList
+{
+    uint32_t first = 0;
+    uint32_t size  = 0;
+};
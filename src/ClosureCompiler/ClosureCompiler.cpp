@@ -0,0 +1,577 @@
+#include "ClosureCompiler.h"
+
+#include "../Evaluator/EvaluatorError.h"
+#include "../Function/RunCall.h"
+#include "../Operators/Operators.h"
+
+namespace
+{
+
+template <BinaryOperator Op>
+CompiledExpression binary(CompiledExpression left, CompiledExpression right)
+{
+    return [left = std::move(left), right = std::move(right)](ExecutionContext& context)
+    {
+        Value lhs = left(context);
+        Value rhs = right(context);
+        return Operators::binary(Op, lhs, rhs);
+    };
+}
+
+CompiledExpression binary(BinaryOperator op, CompiledExpression left, CompiledExpression right)
+{
+    switch (op)
+    {
+        case BinaryOperator::Add:
+            return binary<BinaryOperator::Add>(std::move(left), std::move(right));
+        case BinaryOperator::Subtract:
+            return binary<BinaryOperator::Subtract>(std::move(left), std::move(right));
+        case BinaryOperator::Multiply:
+            return binary<BinaryOperator::Multiply>(std::move(left), std::move(right));
+        case BinaryOperator::Divide:
+            return binary<BinaryOperator::Divide>(std::move(left), std::move(right));
+        case BinaryOperator::Equal:
+            return binary<BinaryOperator::Equal>(std::move(left), std::move(right));
+        case BinaryOperator::NotEqual:
+            return binary<BinaryOperator::NotEqual>(std::move(left), std::move(right));
+        case BinaryOperator::Greater:
+            return binary<BinaryOperator::Greater>(std::move(left), std::move(right));
+        case BinaryOperator::GreaterEqual:
+            return binary<BinaryOperator::GreaterEqual>(std::move(left), std::move(right));
+        case BinaryOperator::Less:
+            return binary<BinaryOperator::Less>(std::move(left), std::move(right));
+        default:
+            return binary<BinaryOperator::LessEqual>(std::move(left), std::move(right));
+    }
+}
+
+// Evaluates the callee and pushes the arguments of a call, checking them against its arity
+Value prepareCall(ExecutionContext&                      context,
+                  const CompiledExpression&              callee,
+                  const std::vector<CompiledExpression>& arguments)
+{
+    Value function = callee(context);
+    if (!function.isCallable())
+    {
+        throw EvaluatorError("Attempt to call a non-function object");
+    }
+
+    for (const auto& argument : arguments)
+    {
+        Value value = argument(context);
+        context.stack.push_back(std::move(value));
+    }
+
+    const auto arity = static_cast<const Callable*>(function.asObject())->arity();
+    if (arguments.size() != static_cast<size_t>(arity))
+    {
+        throw EvaluatorError("Incorrect number of arguments to function.");
+    }
+    return function;
+}
+
+// Calls `function` with the `argumentCount` arguments on top of the stack, then pops them
+Value callArguments(ExecutionContext& context, const Value& function, size_t argumentCount)
+{
+    auto&        stack        = context.stack;
+    const size_t argumentBase = stack.size() - argumentCount;
+
+    auto  callable = static_cast<const Callable*>(function.asObject());
+    Value result   = callable->call({stack.data() + argumentBase, argumentCount});
+    stack.resize(argumentBase);
+    return result;
+}
+
+}  // namespace
+
+Value CompiledFunction::call(std::span<Value> arguments) const
+{
+    // The arguments are the top of the context's stack and become the start of the new frame
+    return context.call(*this);
+}
+
+Value ExecutionContext::call(const CompiledFunction& function)
+{
+    const size_t base           = stack.size() - function.arity();
+    const size_t callerBase     = frameBase;
+    Environment* callerCaptures = captures;
+    frameBase                   = base;
+
+    const Completion completion = runCall(stack,
+                                          base,
+                                          function,
+                                          tailCallee,
+                                          [this](const CompiledFunction& current)
+                                          {
+                                              captures = current.getClosure();
+                                              return current.getPrototype().body(*this);
+                                          });
+
+    frameBase = callerBase;
+    captures  = callerCaptures;
+    return completion == Completion::Return ? std::move(returnValue) : Value();
+}
+
+std::vector<CompiledStatement> ClosureCompiler::compile(const Ast& tree)
+{
+    ast = &tree;
+    std::vector<CompiledStatement> program;
+    for (StatementId stmnt : tree.getStatements())
+    {
+        program.push_back(compile(stmnt));
+    }
+    return program;
+}
+
+CompiledExpression ClosureCompiler::compile(ExpressionId expr)
+{
+    visit(*this, *ast, expr);
+    return std::move(expression);
+}
+
+CompiledStatement ClosureCompiler::compile(StatementId stmnt)
+{
+    visit(*this, *ast, stmnt);
+    return std::move(statement);
+}
+
+CompiledStatement ClosureCompiler::compileDefine(const VariableLocation& location,
+                                                 CompiledExpression      value)
+{
+    const uint32_t index = location.index;
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                context.globals.define(index, value(context));
+                return Completion::Normal;
+            };
+        case VariableLocation::Kind::Frame:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result         = value(context);
+                context.local(index) = std::move(result);
+                return Completion::Normal;
+            };
+        case VariableLocation::Kind::Cell:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result                = value(context);
+                context.cellAt(index).value = std::move(result);
+                return Completion::Normal;
+            };
+        default:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                context.captures->assign(index, value(context));
+                return Completion::Normal;
+            };
+    }
+}
+
+CompiledExpression ClosureCompiler::compileGet(const VariableLocation& location)
+{
+    // While the local is undefined, read the variable the name referred to before it
+    if (location.fallback)
+    {
+        VariableLocation local = location;
+        local.fallback         = nullptr;
+        return [local = compileGet(local), fallback = compileGet(*location.fallback)](
+                   ExecutionContext& context)
+        {
+            Value value = local(context);
+            return value.isUndefined() ? fallback(context) : value;
+        };
+    }
+
+    const uint32_t index = location.index;
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            return [index](ExecutionContext& context) { return context.globals.get(index); };
+        case VariableLocation::Kind::Frame:
+            return [index](ExecutionContext& context) { return context.local(index); };
+        case VariableLocation::Kind::Cell:
+            return [index](ExecutionContext& context) { return context.cellAt(index).value; };
+        default:
+            return [index](ExecutionContext& context) { return context.captures->get(index); };
+    }
+}
+
+CompiledExpression ClosureCompiler::compileAssign(const VariableLocation& location,
+                                                  CompiledExpression      value)
+{
+    // While the local is undefined, assign the variable the name referred to before it. Running
+    // `value` cannot declare the local, so the target is picked before it runs.
+    if (location.fallback)
+    {
+        VariableLocation local = location;
+        local.fallback         = nullptr;
+        return [get = compileGet(local),
+                assign = compileAssign(local, value),
+                fallback = compileAssign(*location.fallback, value)](ExecutionContext& context)
+        { return get(context).isUndefined() ? fallback(context) : assign(context); };
+    }
+
+    const uint32_t index = location.index;
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result = value(context);
+                context.globals.assign(index, result);
+                return result;
+            };
+        case VariableLocation::Kind::Frame:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result         = value(context);
+                context.local(index) = result;
+                return result;
+            };
+        case VariableLocation::Kind::Cell:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result                = value(context);
+                context.cellAt(index).value = result;
+                return result;
+            };
+        default:
+            return [index, value = std::move(value)](ExecutionContext& context)
+            {
+                Value result = value(context);
+                context.captures->assign(index, result);
+                return result;
+            };
+    }
+}
+
+void ClosureCompiler::visitPrintStatement(const PrintStatement& stmnt, Environment* env)
+{
+    if (!stmnt.getExpression())
+    {
+        statement = [](ExecutionContext&) { return Completion::Normal; };
+        return;
+    }
+
+    statement = [value = compile(stmnt.getExpression())](ExecutionContext& context)
+    {
+        value(context).print();
+        return Completion::Normal;
+    };
+}
+
+void ClosureCompiler::visitExpressionStatement(const ExpressionStatement& stmnt, Environment* env)
+{
+    if (!stmnt.getExpression())
+    {
+        statement = [](ExecutionContext&) { return Completion::Normal; };
+        return;
+    }
+
+    auto value = compile(stmnt.getExpression());
+    if (stmnt.toPrint())
+    {
+        statement = [value = std::move(value)](ExecutionContext& context)
+        {
+            value(context).print();
+            return Completion::Normal;
+        };
+        return;
+    }
+
+    statement = [value = std::move(value)](ExecutionContext& context)
+    {
+        value(context);
+        return Completion::Normal;
+    };
+}
+
+void ClosureCompiler::visitVariableStatement(const VariableStatement& stmnt, Environment* env)
+{
+    CompiledExpression value = [](ExecutionContext&) { return Value(); };
+    if (stmnt.getInitializer())
+    {
+        value = compile(stmnt.getInitializer());
+    }
+    statement = compileDefine(stmnt.getLocation(), std::move(value));
+}
+
+void ClosureCompiler::visitBlockStatement(const BlockStatement& stmnt, Environment* env)
+{
+    std::vector<CompiledStatement> statements;
+    for (StatementId inner : ast->get(stmnt.getStatements()))
+    {
+        statements.push_back(compile(inner));
+    }
+
+    const auto& scope = stmnt.getScope();
+    statement         = [statements = std::move(statements),
+                 offset     = scope.frameOffset,
+                 count      = scope.slotCount](ExecutionContext& context)
+    {
+        Completion completion = Completion::Normal;
+        for (const auto& inner : statements)
+        {
+            completion = inner(context);
+            if (completion != Completion::Normal)
+            {
+                break;
+            }
+        }
+
+        // Release the block's locals; the slots are reused by the next scope at the same offset
+        for (uint32_t slot = offset; slot < offset + count; ++slot)
+        {
+            context.local(slot) = Value::undefined();
+        }
+        return completion;
+    };
+}
+
+void ClosureCompiler::visitIfStatement(const IfStatement& stmnt, Environment* env)
+{
+    auto condition  = compile(stmnt.getCondition());
+    auto thenBranch = compile(stmnt.getThenBranch());
+    if (!stmnt.getElseBranch())
+    {
+        statement = [condition = std::move(condition),
+                     thenBranch = std::move(thenBranch)](ExecutionContext& context)
+        { return condition(context).isTruthy() ? thenBranch(context) : Completion::Normal; };
+        return;
+    }
+
+    statement = [condition  = std::move(condition),
+                 thenBranch = std::move(thenBranch),
+                 elseBranch = compile(stmnt.getElseBranch())](ExecutionContext& context)
+    { return condition(context).isTruthy() ? thenBranch(context) : elseBranch(context); };
+}
+
+void ClosureCompiler::visitWhileStatement(const WhileStatement& stmnt, Environment* env)
+{
+    statement = [condition = compile(stmnt.getCondition()),
+                 body      = compile(stmnt.getBody())](ExecutionContext& context)
+    {
+        while (condition(context).isTruthy())
+        {
+            Completion completion = body(context);
+            if (completion != Completion::Normal)
+            {
+                return completion;
+            }
+        }
+        return Completion::Normal;
+    };
+}
+
+void ClosureCompiler::visitForStatement(const ForStatement& stmnt, Environment* env)
+{
+    // Missing clauses compile to no-ops, and a missing condition is always true
+    CompiledStatement  initializer = [](ExecutionContext&) { return Completion::Normal; };
+    CompiledExpression condition   = [](ExecutionContext&) { return Value(true); };
+    CompiledExpression increment   = [](ExecutionContext&) { return Value(); };
+    if (stmnt.getInitializer())
+    {
+        initializer = compile(stmnt.getInitializer());
+    }
+    if (stmnt.getCondition())
+    {
+        condition = compile(stmnt.getCondition());
+    }
+    if (stmnt.getIncrement())
+    {
+        increment = compile(stmnt.getIncrement());
+    }
+
+    statement = [initializer = std::move(initializer),
+                 condition   = std::move(condition),
+                 increment   = std::move(increment),
+                 body        = compile(stmnt.getBody())](ExecutionContext& context)
+    {
+        initializer(context);
+        while (condition(context).isTruthy())
+        {
+            Completion completion = body(context);
+            if (completion != Completion::Normal)
+            {
+                return completion;
+            }
+            increment(context);
+        }
+        return Completion::Normal;
+    };
+}
+
+void ClosureCompiler::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& stmnt,
+                                                       Environment*                       env)
+{
+    auto proto            = std::make_shared<CompiledProto>();
+    proto->name           = ast->getString(stmnt.getName());
+    proto->arity          = stmnt.getParameters().size;
+    proto->frameSize      = stmnt.getFrameSize();
+    proto->parameterScope = stmnt.getParameterScope();
+    proto->parameterSlots = stmnt.getParameterSlots();
+    proto->captures       = stmnt.getCaptures();
+    proto->body           = compile(stmnt.getBody());
+
+    // The closure shares the Cells of only the variables the function refers to. A local function
+    // that refers to itself captures its own, still empty, Cell.
+    CompiledExpression function = [proto = std::shared_ptr<const CompiledProto>(proto)](
+                                      ExecutionContext& context)
+    {
+        std::unique_ptr<Environment> closure;
+        if (!proto->captures.empty())
+        {
+            std::vector<Value> cells;
+            cells.reserve(proto->captures.size());
+            for (const auto& capture : proto->captures)
+            {
+                if (capture.fromFrame)
+                {
+                    context.cellAt(capture.index);
+                    cells.push_back(context.local(capture.index));
+                }
+                else
+                {
+                    cells.push_back(context.captures->getCell(capture.index));
+                }
+            }
+            closure = std::make_unique<Environment>(std::move(cells));
+        }
+        return Value(new CompiledFunction(proto, std::move(closure), context));
+    };
+    statement = compileDefine(stmnt.getLocation(), std::move(function));
+}
+
+void ClosureCompiler::visitReturnStatement(const ReturnStatement& stmnt, Environment* env)
+{
+    if (stmnt.isTailCall())
+    {
+        const auto& call = ast->get<CallExpression>(stmnt.getExpression());
+
+        std::vector<CompiledExpression> arguments;
+        for (ExpressionId argument : ast->get(call.getArguments()))
+        {
+            arguments.push_back(compile(argument));
+        }
+
+        statement = [callee    = compile(call.getCallee()),
+                     arguments = std::move(arguments)](ExecutionContext& context)
+        {
+            Value function = prepareCall(context, callee, arguments);
+
+            // Only Lox functions have a frame to reuse; native functions are called directly
+            if (dynamic_cast<const CompiledFunction*>(function.asObject()))
+            {
+                context.tailCallee = std::move(function);
+                return Completion::TailCall;
+            }
+            context.returnValue = callArguments(context, function, arguments.size());
+            return Completion::Return;
+        };
+        return;
+    }
+
+    CompiledExpression value = [](ExecutionContext&) { return Value(); };
+    if (stmnt.getExpression())
+    {
+        value = compile(stmnt.getExpression());
+    }
+    statement = [value = std::move(value)](ExecutionContext& context)
+    {
+        context.returnValue = value(context);
+        return Completion::Return;
+    };
+}
+
+void ClosureCompiler::visitLiteralExpression(const LiteralExpression& expr, Environment* env)
+{
+    expression = [value = expr.getConstant()](ExecutionContext&) { return value; };
+}
+
+void ClosureCompiler::visitUnaryExpression(const UnaryExpression& expr, Environment* env)
+{
+    auto operand = compile(expr.getRight());
+    if (expr.getOperator() == UnaryOperator::Negate)
+    {
+        expression = [operand = std::move(operand)](ExecutionContext& context)
+        { return Operators::unary(UnaryOperator::Negate, operand(context)); };
+        return;
+    }
+
+    expression = [operand = std::move(operand)](ExecutionContext& context)
+    { return Operators::unary(UnaryOperator::Not, operand(context)); };
+}
+
+void ClosureCompiler::visitBinaryExpression(const BinaryExpression& expr, Environment* env)
+{
+    auto left  = compile(expr.getLeft());
+    auto right = compile(expr.getRight());
+    expression = binary(expr.getOperator(), std::move(left), std::move(right));
+}
+
+void ClosureCompiler::visitGroupingExpression(const GroupingExpression& expr, Environment* env)
+{
+    // Grouping only matters to the parser
+    expression = compile(expr.getExpression());
+}
+
+void ClosureCompiler::visitVariableExpression(const VariableExpression& expr, Environment* env)
+{
+    expression = compileGet(expr.getLocation());
+}
+
+void ClosureCompiler::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+{
+    expression = compileAssign(expr.getLocation(), compile(expr.getValue()));
+}
+
+void ClosureCompiler::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    auto left  = compile(expr.getLeft());
+    auto right = compile(expr.getRight());
+    if (expr.getOperator() == LogicalOperator::Or)
+    {
+        expression = [left = std::move(left), right = std::move(right)](ExecutionContext& context)
+        {
+            Value value = left(context);
+            return value.isTruthy() ? value : right(context);
+        };
+        return;
+    }
+
+    expression = [left = std::move(left), right = std::move(right)](ExecutionContext& context)
+    {
+        Value value = left(context);
+        return value.isTruthy() ? right(context) : value;
+    };
+}
+
+void ClosureCompiler::visitCallExpression(const CallExpression& expr, Environment* env)
+{
+    std::vector<CompiledExpression> arguments;
+    for (ExpressionId argument : ast->get(expr.getArguments()))
+    {
+        arguments.push_back(compile(argument));
+    }
+
+    expression = [callee    = compile(expr.getCallee()),
+                  arguments = std::move(arguments)](ExecutionContext& context)
+    {
+        Value function = prepareCall(context, callee, arguments);
+        return callArguments(context, function, arguments.size());
+    };
+}
+
+void ClosureCompiler::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                        Environment*                        env)
+{
+    visit(*this, *ast, expr.getAssignment(), env);
+}
+
+void ClosureCompiler::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getComparison(), env);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+
+#include "../Ast/Ast.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+#include "CompiledCode.h"
+
+// Closure-compilation engine. Walks a resolved program once and turns every node into a
+// CompiledExpression or CompiledStatement, specialized on its operator and variable location.
+// Running the result needs no visitor dispatch and no further inspection of the AST.
+class ClosureCompiler : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    // Compiles the program in `tree`
+    std::vector<CompiledStatement> compile(const Ast& tree);
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    const Ast* ast = nullptr;
+
+    // Result of the last visit
+    CompiledExpression expression;
+    CompiledStatement  statement;
+
+    CompiledExpression compile(ExpressionId expr);
+    CompiledStatement  compile(StatementId stmnt);
+
+    // Stores the value produced by `value` at `location`
+    CompiledStatement compileDefine(const VariableLocation& location, CompiledExpression value);
+
+    // Reads the variable at `location`
+    CompiledExpression compileGet(const VariableLocation& location);
+
+    // Stores the value produced by `value` at `location` and produces it
+    CompiledExpression compileAssign(const VariableLocation& location, CompiledExpression value);
+};
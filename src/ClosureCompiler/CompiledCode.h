@@ -0,0 +1,109 @@
+#pragma once
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Function/Callable.h"
+#include "../Statement/StatementVisitor.h"
+
+struct ExecutionContext;
+
+// Each AST node is compiled once into a function object with its children, operator and resolved
+// variable location already bound, so running it is a direct call rather than a visitor dispatch.
+using CompiledExpression = std::function<Value(ExecutionContext&)>;
+using CompiledStatement  = std::function<Completion(ExecutionContext&)>;
+
+// A compiled function body, along with the frame layout the Resolver computed for it
+struct CompiledProto
+{
+    std::string name;
+
+    uint32_t              arity     = 0;
+    uint32_t              frameSize = 0;
+    ScopeLayout           parameterScope;
+    std::vector<uint32_t> parameterSlots;
+    std::vector<Capture>  captures;
+
+    CompiledStatement body;
+};
+
+class CompiledFunction : public Callable
+{
+   public:
+    CompiledFunction(std::shared_ptr<const CompiledProto> proto,
+                     std::unique_ptr<Environment>         closure,
+                     ExecutionContext&                    context)
+        : proto(std::move(proto)), closure(std::move(closure)), context(context)
+    {
+        if (this->closure)
+        {
+            Collector::track(*this);
+        }
+    }
+
+    Value call(std::span<Value> arguments) const override;
+
+    int arity() const override { return proto->arity; }
+
+    bool isTruthy() const override { return false; }
+
+    void print() const override { std::cout << "<fn " + proto->name + ">" << std::endl; }
+
+    void references(std::vector<Object*>& referenced) const override
+    {
+        if (closure)
+        {
+            closure->references(referenced);
+        }
+    }
+    void clearReferences() override { closure.reset(); }
+
+    const CompiledProto& getPrototype() const { return *proto; }
+    Environment*         getClosure() const { return closure.get(); }
+
+   private:
+    std::shared_ptr<const CompiledProto> proto;
+
+    // Captured variables, or null if the function captures none
+    std::unique_ptr<Environment> closure;
+
+    ExecutionContext& context;
+};
+
+// Runtime state shared by the compiled code of a program. Frames are laid out on the stack exactly
+// as in the Evaluator.
+struct ExecutionContext
+{
+    ExecutionContext(GlobalEnvironment& globals, uint32_t frameSize) : globals(globals)
+    {
+        stack.reserve(initialStackSize);
+        stack.resize(frameSize, Value::undefined());
+    }
+
+    static constexpr size_t initialStackSize = 1024;
+
+    GlobalEnvironment& globals;
+
+    std::vector<Value> stack;
+
+    // Start of the current function's frame in the stack
+    size_t frameBase = 0;
+
+    // Variables captured by the running function
+    Environment* captures = nullptr;
+
+    // Value of the `return` being completed, and function of the tail call being completed
+    Value returnValue;
+    Value tailCallee;
+
+    Value& local(uint32_t index) { return stack[frameBase + index]; }
+    Cell&  cellAt(uint32_t index) { return cellIn(stack[frameBase + index]); }
+
+    // Runs a function whose arguments are on top of the stack. Tail calls made by the function
+    // reuse its frame.
+    Value call(const CompiledFunction& function);
+};
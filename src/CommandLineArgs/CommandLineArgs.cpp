@@ -3,34 +3,108 @@
 #include <iostream>
 #include <unordered_set>
 
-const std::unordered_set<std::string> validCommands = {"tokenize", "parse", "evaluate", "run"};
+const std::unordered_set<std::string> validCommands = {
+    "tokenize", "parse", "evaluate", "run", "compile"};
 
-CommandLineArgs::CommandLineArgs(int argc, char* argv[]) : argc(argc), argv(argv) {}
+// Accepted values of each option. A flag given without a value has the value "".
+const std::unordered_map<std::string, std::unordered_set<std::string>> validOptions = {
+    {"engine", {"tree", "vm", "closure"}}, {"jit", {""}}, {"O", {""}}, {"dump-optimized", {""}}};
+
+CommandLineArgs::CommandLineArgs(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        command = argv[1];
+    }
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg.size() == 2 && arg[0] == '-' && arg[1] != '-')
+        {
+            // Single letter flag, e.g. -O
+            options[arg.substr(1)] = "";
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0)
+        {
+            arguments.push_back(arg);
+            continue;
+        }
+
+        const size_t equals = arg.find('=');
+        if (equals == std::string::npos)
+        {
+            options[arg.substr(2)] = "";
+        }
+        else
+        {
+            options[arg.substr(2, equals - 2)] = arg.substr(equals + 1);
+        }
+    }
+}
 
 bool CommandLineArgs::validateArgs() const
 {
-    if (argc != 3)
+    const size_t argumentCount = command == "compile" ? 2 : 1;
+    if (command.empty() || arguments.size() != argumentCount)
     {
-        std::cerr << "Usage: ./your_program <command> <argument>" << std::endl;
+        std::cerr << "Usage: ./your_program <command> [--engine=tree|vm|closure] [--jit] [-O] "
+                     "[--dump-optimized] <argument>"
+                  << std::endl
+                  << "       ./your_program compile [-O] <file> <out.cpp>" << std::endl;
         return false;
     }
 
-    const std::string command = argv[1];
     if (validCommands.find(command) == validCommands.end())
     {
         std::cerr << "Unknown command: " << command << std::endl;
         return false;
     }
 
+    for (const auto& [name, value] : options)
+    {
+        auto valid = validOptions.find(name);
+        if (valid == validOptions.end() || valid->second.find(value) == valid->second.end())
+        {
+            std::cerr << "Unknown option: " << (name.size() == 1 ? "-" : "--") << name
+                      << (value.empty() ? "" : "=" + value) << std::endl;
+            return false;
+        }
+    }
+
+    // Only the tree-walking Evaluator runs hot functions as machine code
+    if (hasOption("jit") && getOption("engine", "tree") != "tree")
+    {
+        std::cerr << "--jit requires --engine=tree" << std::endl;
+        return false;
+    }
+
     return true;
 }
 
 std::string CommandLineArgs::getCommand() const
 {
-    return argv[1];
+    return command;
 }
 
 std::string CommandLineArgs::getArgument() const
 {
-    return argv[2];
+    return arguments.front();
+}
+
+std::string CommandLineArgs::getOutputPath() const
+{
+    return arguments.back();
+}
+
+std::string CommandLineArgs::getOption(const std::string& name, const std::string& fallback) const
+{
+    auto it = options.find(name);
+    return it != options.end() ? it->second : fallback;
+}
+
+bool CommandLineArgs::hasOption(const std::string& name) const
+{
+    return options.find(name) != options.end();
 }
@@ -1,6 +1,10 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+// Parses `<command> [--option=value ...] <argument>`, or `compile <file> <out.cpp>`. Options may
+// appear anywhere after the command; single letter ones are written `-X`.
 class CommandLineArgs
 {
    public:
@@ -12,7 +16,19 @@ class CommandLineArgs
 
     std::string getArgument() const;
 
+    // Where `compile` writes its output
+    std::string getOutputPath() const;
+
+    // Value of `--name=value`, or `fallback` if the option was not given
+    std::string getOption(const std::string& name, const std::string& fallback = "") const;
+
+    // Whether `--name` was given, with or without a value
+    bool hasOption(const std::string& name) const;
+
    private:
-    int    argc;
-    char** argv;
+    std::string command;
+
+    std::vector<std::string> arguments;
+
+    std::unordered_map<std::string, std::string> options;
 };
@@ -1,49 +1,66 @@
 #include "Environment.h"
 
+#include <cstdlib>
+
 #include "../Function/ClockFunction.h"
 
-void Environment::define(const std::string& name, std::shared_ptr<ResultBase> value)
+Cell& cellIn(Value& slot)
 {
-    variables[name] = std::move(value);
+    if (slot.isUndefined())
+    {
+        slot = Value(new Cell(Value::undefined()));
+    }
+    return *static_cast<Cell*>(slot.asObject());
 }
 
-void Environment::assign(const std::string& name, std::shared_ptr<ResultBase> value)
+void enterFrame(std::vector<Value>&          stack,
+                size_t                       base,
+                const std::vector<uint32_t>& parameterSlots,
+                const ScopeLayout&           parameterScope,
+                uint32_t                     frameSize)
 {
-    if (variables.find(name) != variables.end())
+    // The arguments already sit in their frame slots unless a parameter name is repeated
+    for (size_t i = 0; i < parameterSlots.size(); ++i)
     {
-        variables[name] = std::move(value);
-        return;
+        if (parameterSlots[i] != i)
+        {
+            stack[base + parameterSlots[i]] = std::move(stack[base + i]);
+        }
     }
+    stack.resize(base + frameSize, Value::undefined());
 
-    // If not found in the current scope, check the enclosing scope
-    if (enclosing)
+    for (uint32_t slot = 0; slot < parameterScope.slotCount; ++slot)
     {
-        enclosing->assign(name, std::move(value));
-        return;
+        if (parameterScope.captured[slot])
+        {
+            stack[base + slot] = Value(new Cell(std::move(stack[base + slot])));
+        }
     }
-
-    std::cerr << "Undefined variable '" + name + "'." << std::endl;
-    std::exit(70);
 }
 
-const std::shared_ptr<ResultBase>& Environment::get(const std::string& name) const
+uint32_t GlobalEnvironment::indexOf(const std::string& name)
 {
-    auto it = variables.find(name);
-    if (it != variables.end())
+    auto it = indices.find(name);
+    if (it != indices.end())
     {
         return it->second;
     }
 
-    if (enclosing)
-    {
-        return enclosing->get(name);
-    }
+    uint32_t index = names.size();
+    indices.emplace(name, index);
+    names.push_back(name);
+    values.emplace_back();
+    defined.push_back(false);
+    return index;
+}
 
-    std::cerr << "Undefined variable '" + name + "'." << std::endl;
+void GlobalEnvironment::undefinedVariable(uint32_t index) const
+{
+    std::cerr << "Undefined variable '" + names[index] + "'." << std::endl;
     std::exit(70);
 }
 
-void Environment::initializeGlobalScope()
+void GlobalEnvironment::initializeGlobalScope()
 {
-    define("clock", std::make_shared<ClockFunction>());
+    define(indexOf("clock"), Value(new ClockFunction()));
 }
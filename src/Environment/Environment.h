@@ -1,31 +1,173 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
-#include "../Result/Result.h"
+#include "../Value/Pool.h"
+#include "../Value/Value.h"
 
-class Environment : public std::enable_shared_from_this<Environment>
+// Where a variable lives at runtime, as computed by the Resolver: an index into the
+// GlobalEnvironment, a slot in the current function's frame on the Evaluator's stack, a frame slot
+// holding the Cell of a variable that closures capture, or one of the current closure's captures.
+struct VariableLocation
+{
+    enum class Kind : uint8_t
+    {
+        Global,
+        Frame,
+        Cell,
+        Capture
+    };
+
+    Kind     kind  = Kind::Global;
+    uint32_t index = 0;
+
+    // Set for a local whose declaration a branch or loop may skip: where the name refers to while
+    // the local is still undefined, as it would without that declaration
+    const VariableLocation* fallback = nullptr;
+};
+
+// Where a closure finds each variable it captures when it is created: the Cell in a frame slot of
+// the defining function, or one of the defining function's own captures
+struct Capture
+{
+    bool     fromFrame = true;
+    uint32_t index     = 0;
+};
+
+// How a block or parameter scope is laid out in its function's frame, and which of its slots are
+// captured by a closure
+struct ScopeLayout
+{
+    uint32_t          slotCount   = 0;
+    uint32_t          frameOffset = 0;
+    std::vector<bool> captured;
+};
+
+// Box for a local variable that a closure captures, shared by the frame that declared it and every
+// closure that refers to it
+class Cell : public Object
 {
    public:
-    explicit Environment(std::shared_ptr<Environment> enclosing = nullptr)
-        : enclosing(std::move(enclosing))
+    explicit Cell(Value value) : Object(Kind::Cell), value(std::move(value))
     {
+        Collector::track(*this);
     }
 
-    std::shared_ptr<Environment> getSharedPtr() { return shared_from_this(); }
+    Value value;
+
+    bool isTruthy() const override { return value.isTruthy(); }
+    void print() const override { value.print(); }
+
+    void references(std::vector<Object*>& referenced) const override
+    {
+        if (value.isObject())
+        {
+            referenced.push_back(value.asObject());
+        }
+    }
+    void clearReferences() override { value = Value(); }
+};
+
+// Cell held by the frame slot of a captured local, created if the local's declaration has not run
+// yet or was skipped by a branch
+Cell& cellIn(Value& slot);
+
+// Turns the arguments of a call, which start at `base` on top of `stack`, into the callee's frame:
+// a repeated parameter name takes the last argument, the frame is sized for the function's locals,
+// and captured parameters are boxed in Cells. Shared by every execution engine.
+void enterFrame(std::vector<Value>&          stack,
+                size_t                       base,
+                const std::vector<uint32_t>& parameterSlots,
+                const ScopeLayout&           parameterScope,
+                uint32_t                     frameSize);
+
+// The variables a closure captures: one Cell per captured variable, rather than the whole chain of
+// scopes it was defined in
+class Environment
+{
+   public:
+    explicit Environment(std::vector<Value> cells) : cells(std::move(cells)) {}
+
+    static void* operator new(size_t size) { return Pool::allocate(size); }
+    static void  operator delete(void* block, size_t size) { Pool::deallocate(block, size); }
+
+    const Value& get(uint32_t index) const { return cell(index).value; }
 
-    void define(const std::string& name, std::shared_ptr<ResultBase> value);
-    void assign(const std::string& name, std::shared_ptr<ResultBase> value);
+    void assign(uint32_t index, Value value) { cell(index).value = std::move(value); }
+
+    const Value& getCell(uint32_t index) const { return cells[index]; }
+
+    bool isEmpty() const { return cells.empty(); }
+
+    // Appends the Cells, for the Collector
+    void references(std::vector<Object*>& referenced) const
+    {
+        for (const auto& cell : cells)
+        {
+            referenced.push_back(cell.asObject());
+        }
+    }
+    void clear() { cells.clear(); }
+
+   private:
+    std::vector<Value> cells;
+
+    Cell& cell(uint32_t index) const { return *static_cast<Cell*>(cells[index].asObject()); }
+};
+
+// The global scope. Names are interned to indices by the Resolver, so lookups at runtime are array
+// accesses; a slot that has not been defined yet reports an undefined variable, as globals may be
+// referenced before their declaration has executed. No slots are added once resolution is done,
+// so references to them stay valid while the program runs.
+class GlobalEnvironment
+{
+   public:
+    // Returns the index of `name`, adding a new undefined slot the first time it is seen
+    uint32_t indexOf(const std::string& name);
+
+    void define(uint32_t index, Value value)
+    {
+        values[index]  = std::move(value);
+        defined[index] = true;
+    }
+
+    bool isDefined(uint32_t index) const { return defined[index]; }
+
+    const Value& get(uint32_t index) const
+    {
+        if (!defined[index])
+        {
+            undefinedVariable(index);
+        }
+        return values[index];
+    }
+
+    void assign(uint32_t index, Value value)
+    {
+        if (!defined[index])
+        {
+            undefinedVariable(index);
+        }
+        values[index] = std::move(value);
+    }
 
     void initializeGlobalScope();
 
-    const std::shared_ptr<ResultBase>& get(const std::string& name) const;
+    size_t             size() const { return names.size(); }
+    const std::string& getName(uint32_t index) const { return names[index]; }
 
    private:
-    std::unordered_map<std::string, std::shared_ptr<ResultBase>> variables;
+    std::unordered_map<std::string, uint32_t> indices;
+
+    std::vector<std::string> names;
+    std::vector<Value>       values;
+    std::vector<bool>        defined;
 
-    std::shared_ptr<Environment> enclosing;
+    [[noreturn]] void undefinedVariable(uint32_t index) const;
 };
@@ -2,416 +2,503 @@
 
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <string>
 
-#include "../Expression/Expression.h"
 #include "../Function/Callable.h"
 #include "../Function/LoxFunction.h"
+#include "../Function/RunCall.h"
 #include "../Operators/Operators.h"
-#include "../Statement/Statement.h"
 #include "EvaluatorError.h"
 
-void Evaluator::visitPrintStatement(const PrintStatement& statement, Environment* env)
+void Evaluator::define(const VariableLocation& location, Value value, Environment* env)
 {
-    auto expr = statement.getExpression();
-    if (expr)
+    switch (location.kind)
     {
-        expr->accept(*this, env);
-        result->print();
+        case VariableLocation::Kind::Global:
+            globals.define(location.index, std::move(value));
+            break;
+        case VariableLocation::Kind::Frame:
+            stack[frameBase + location.index] = std::move(value);
+            break;
+        case VariableLocation::Kind::Cell:
+            cellAt(location.index).value = std::move(value);
+            break;
+        case VariableLocation::Kind::Capture:
+            env->assign(location.index, std::move(value));
+            break;
     }
 }
 
-void Evaluator::visitExpressionStatement(const ExpressionStatement& statement, Environment* env)
+void Evaluator::assign(const VariableLocation& location, const Value& value, Environment* env)
 {
-    auto expr = statement.getExpression();
-    if (expr)
-    {
-        expr->accept(*this, env);
-    }
-    if (statement.toPrint())
+    const VariableLocation& target = location.fallback ? followFallbacks(location, env) : location;
+    switch (target.kind)
     {
-        result->print();
+        case VariableLocation::Kind::Global:
+            globals.assign(target.index, value);
+            break;
+        case VariableLocation::Kind::Frame:
+            stack[frameBase + target.index] = value;
+            break;
+        case VariableLocation::Kind::Cell:
+            cellAt(target.index).value = value;
+            break;
+        case VariableLocation::Kind::Capture:
+            env->assign(target.index, value);
+            break;
     }
 }
 
-void Evaluator::visitVariableStatement(const VariableStatement& statement, Environment* env)
+const VariableLocation& Evaluator::followFallbacks(const VariableLocation& location,
+                                                   Environment*            env)
 {
-    result.reset();
-    auto initializer = statement.getInitializer();
-    if (initializer)
-    {
-        initializer->accept(*this, env);
-    }
-    if (env)
+    // Only locals have fallbacks, so the chain ends at a defined local or a global
+    const VariableLocation* target = &location;
+    while (target->fallback && local(*target, env).isUndefined())
     {
-        env->define(statement.getName(), result);
+        target = target->fallback;
     }
+    return *target;
 }
 
-void Evaluator::visitBlockStatement(const BlockStatement& statement, Environment* env)
+const Value& Evaluator::local(const VariableLocation& location, Environment* env)
 {
-    auto blockEnv =
-        env ? std::make_shared<Environment>(env->getSharedPtr()) : std::make_shared<Environment>();
-    for (const auto& stmnt : statement.getStatements())
+    switch (location.kind)
     {
-        stmnt->accept(*this, blockEnv.get());
+        case VariableLocation::Kind::Frame:
+            return stack[frameBase + location.index];
+        case VariableLocation::Kind::Cell:
+            return cellAt(location.index).value;
+        default:
+            return env->get(location.index);
     }
 }
 
-void Evaluator::visitIfStatement(const IfStatement& statement, Environment* env)
+Value Evaluator::load(const FusedOperand& operand, Environment* env)
 {
-    statement.getCondition()->accept(*this, env);
-    if (result->isTruthy())
+    if (operand.constant)
     {
-        statement.getThenBranch()->accept(*this, env);
+        return *operand.constant;
     }
-    else if (statement.getElseBranch())
+    if (operand.isVariable())
     {
-        statement.getElseBranch()->accept(*this, env);
+        return Evaluator::visitVariableExpression(
+            ast.get<VariableExpression>(operand.expression), env);
     }
+    return visit(*this, ast, operand.expression, env);
 }
 
-void Evaluator::visitWhileStatement(const WhileStatement& statement, Environment* env)
+Cell& Evaluator::cellAt(uint32_t index)
 {
-    while (true)
+    return cellIn(stack[frameBase + index]);
+}
+
+void Evaluator::enableJit()
+{
+    jit = std::make_unique<Jit>(globals, ast);
+}
+
+Value Evaluator::callFunction(const LoxFunction& function)
+{
+    const size_t base = stack.size() - function.arity();
+    if (jit)
     {
-        statement.getCondition()->accept(*this, env);
-        if (!result->isTruthy())
+        Value result;
+        if (jit->tryCall(function, {stack.data() + base, stack.size() - base}, result))
         {
-            break;
+            return result;
         }
-        statement.getBody()->accept(*this, env);
     }
+
+    const size_t callerBase = frameBase;
+    frameBase               = base;
+
+    const Completion completion =
+        runCall(stack,
+                base,
+                function,
+                tailCallee,
+                [this](const LoxFunction& current)
+                { return visit(*this, ast, current.getPrototype().body, current.getClosure()); });
+
+    frameBase = callerBase;
+    return completion == Completion::Return ? std::move(returnValue) : Value();
 }
 
-void Evaluator::visitForStatement(const ForStatement& statement, Environment* env)
+Completion Evaluator::visitPrintStatement(const PrintStatement& statement, Environment* env)
 {
-    if (statement.getInitializer())
+    auto expr = statement.getExpression();
+    if (expr)
     {
-        statement.getInitializer()->accept(*this, env);
+        visit(*this, ast, expr, env).print();
     }
+    return Completion::Normal;
+}
 
-    while (true)
+Completion Evaluator::visitExpressionStatement(const ExpressionStatement& statement,
+                                               Environment*               env)
+{
+    auto expr = statement.getExpression();
+    if (!expr)
     {
-        bool conditionTruthy = true;
-        if (statement.getCondition())
-        {
-            statement.getCondition()->accept(*this, env);
-            conditionTruthy = result->isTruthy();
-        }
-
-        if (!conditionTruthy)
-        {
-            break;
-        }
-
-        statement.getBody()->accept(*this, env);
+        return Completion::Normal;
+    }
 
-        if (statement.getIncrement())
-        {
-            statement.getIncrement()->accept(*this, env);
-        }
+    Value value = visit(*this, ast, expr, env);
+    if (statement.toPrint())
+    {
+        value.print();
     }
+    return Completion::Normal;
 }
 
-void Evaluator::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
-                                                 Environment*                       env)
+Completion Evaluator::visitVariableStatement(const VariableStatement& statement, Environment* env)
 {
-    auto functionDef = std::make_shared<FunctionDefinitionStatement>(
-        statement.getName(), statement.getParameters(), statement.getBody());
-    env->define(statement.getName(),
-                std::make_shared<LoxFunction>(functionDef, env->getSharedPtr()));
+    Value value;
+    auto  initializer = statement.getInitializer();
+    if (initializer)
+    {
+        value = visit(*this, ast, initializer, env);
+    }
+    define(statement.getLocation(), std::move(value), env);
+    return Completion::Normal;
 }
 
-void Evaluator::visitReturnStatement(const ReturnStatement& statement, Environment* env)
+Completion Evaluator::visitBlockStatement(const BlockStatement& statement, Environment* env)
 {
-    result.reset();
-
-    if (statement.getExpression())
+    Completion completion = Completion::Normal;
+    for (StatementId stmnt : ast.get(statement.getStatements()))
     {
-        statement.getExpression()->accept(*this, env);
+        completion = visit(*this, ast, stmnt, env);
+        if (completion != Completion::Normal)
+        {
+            break;
+        }
     }
-    else
+
+    // Release the block's locals; the slots are reused by the next scope at the same offset
+    const auto&  scope = statement.getScope();
+    const size_t begin = frameBase + scope.frameOffset;
+    for (size_t slot = begin; slot < begin + scope.slotCount; ++slot)
     {
-        result = std::make_shared<Result<std::nullptr_t>>();
+        stack[slot] = Value::undefined();
     }
-
-    throw ReturnException(result);
+    return completion;
 }
 
-void Evaluator::visitVariableExpression(const VariableExpression& expression, Environment* env)
+Completion Evaluator::visitIfStatement(const IfStatement& statement, Environment* env)
 {
-    result.reset();
-    auto value = (env) ? env->get(expression.getName()) : nullptr;
-    if (value)
+    if (visit(*this, ast, statement.getCondition(), env).isTruthy())
     {
-        result = value;
+        return visit(*this, ast, statement.getThenBranch(), env);
     }
-    else
+    if (statement.getElseBranch())
     {
-        result = std::make_unique<Result<std::nullptr_t>>();
+        return visit(*this, ast, statement.getElseBranch(), env);
     }
+    return Completion::Normal;
 }
 
-void Evaluator::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+Completion Evaluator::visitWhileStatement(const WhileStatement& statement, Environment* env)
 {
-    result.reset();
-    expr.getValue()->accept(*this, env);
-    if (env)
+    while (visit(*this, ast, statement.getCondition(), env).isTruthy())
     {
-        env->assign(expr.getName(), result);
+        Completion completion = visit(*this, ast, statement.getBody(), env);
+        if (completion != Completion::Normal)
+        {
+            return completion;
+        }
     }
+    return Completion::Normal;
 }
 
-void Evaluator::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+Completion Evaluator::visitForStatement(const ForStatement& statement, Environment* env)
 {
-    const auto op = expr.getOperator();
-    expr.getLeft()->accept(*this, env);
-    if (op == "or" && result->isTruthy())
+    if (statement.getInitializer())
     {
-        return;
+        visit(*this, ast, statement.getInitializer(), env);
     }
-    if (op == "and" && !result->isTruthy())
+
+    while (true)
     {
-        return;
+        if (statement.getCondition() &&
+            !visit(*this, ast, statement.getCondition(), env).isTruthy())
+        {
+            break;
+        }
+
+        Completion completion = visit(*this, ast, statement.getBody(), env);
+        if (completion != Completion::Normal)
+        {
+            return completion;
+        }
+
+        if (statement.getIncrement())
+        {
+            visit(*this, ast, statement.getIncrement(), env);
+        }
     }
-    expr.getRight()->accept(*this, env);
+    return Completion::Normal;
 }
 
-void Evaluator::visitLiteralExpression(const LiteralExpression& literal, Environment* env)
+Completion Evaluator::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
+                                                       Environment*                       env)
 {
-    result.reset();
-    const std::string& value = literal.getValue();
-    switch (literal.getType())
-    {
-        case LiteralType::Boolean:
-            result = std::make_shared<Result<bool>>(value == "true" ? true : false);
-            break;
-        case LiteralType::String:
-            result = std::make_shared<Result<std::string>>(value);
-            break;
-        case LiteralType::Number:
-            try
+    // The closure shares the Cells of only the variables the function refers to. A local function
+    // that refers to itself captures its own, still empty, Cell.
+    std::unique_ptr<Environment> closure;
+    if (!statement.getCaptures().empty())
+    {
+        std::vector<Value> cells;
+        cells.reserve(statement.getCaptures().size());
+        for (const auto& capture : statement.getCaptures())
+        {
+            if (capture.fromFrame)
             {
-                double number = std::stod(value);  // Convert string to double
-                result        = std::make_shared<Result<double>>(number);
+                cellAt(capture.index);
+                cells.push_back(stack[frameBase + capture.index]);
             }
-            catch (const std::invalid_argument& e)
+            else
             {
-                std::cerr << "Error: Invalid number literal: " << value << std::endl;
-                result = std::make_shared<Result<std::nullptr_t>>();  // Use NilResult for errors
+                cells.push_back(env->getCell(capture.index));
             }
-            break;
-        case LiteralType::Nil:
-            result = std::make_shared<Result<std::nullptr_t>>();
-            break;
+        }
+        closure = std::make_unique<Environment>(std::move(cells));
     }
+    Value function(new LoxFunction(statement.getPrototype(), std::move(closure), *this));
+    define(statement.getLocation(), std::move(function), env);
+    return Completion::Normal;
 }
 
-void Evaluator::handleBangOperator()
+Completion Evaluator::visitReturnStatement(const ReturnStatement& statement, Environment* env)
 {
-    auto boolResult = dynamic_cast<Result<bool>*>(result.get());
-    if (boolResult)
+    if (statement.isTailCall())
     {
-        result = std::make_shared<Result<bool>>(!boolResult->getValue());
-        return;
-    }
+        const auto& call   = ast.get<CallExpression>(statement.getExpression());
+        Value       callee = prepareCall(call, env);
 
-    auto doubleResult = dynamic_cast<Result<double>*>(result.get());
-    if (doubleResult)
-    {
-        result = std::make_shared<Result<bool>>(!doubleResult->getValue());
-        return;
+        // Only Lox functions have a frame to reuse; native functions are called directly
+        if (dynamic_cast<const LoxFunction*>(callee.asObject()))
+        {
+            tailCallee = std::move(callee);
+            return Completion::TailCall;
+        }
+
+        returnValue = callArguments(callee, call.getArguments().size);
+        return Completion::Return;
     }
 
-    if (dynamic_cast<Result<std::nullptr_t>*>(result.get()))
+    returnValue = Value();
+    if (statement.getExpression())
     {
-        result = std::make_shared<Result<bool>>(true);
-        return;
+        returnValue = visit(*this, ast, statement.getExpression(), env);
     }
-    throw EvaluatorError("Operand of '!' must be a boolean or nil.");
+    return Completion::Return;
 }
 
-void Evaluator::handleMinusOperator()
+Value Evaluator::visitVariableExpression(const VariableExpression& expression, Environment* env)
 {
-    auto numberResult = dynamic_cast<Result<double>*>(result.get());
-    if (!numberResult)
+    const auto& location = expression.getLocation();
+    if (location.fallback)
     {
-        throw EvaluatorError("Operand of '-' must be a number.");
+        const VariableLocation& target = followFallbacks(location, env);
+        return target.kind == VariableLocation::Kind::Global ? globals.get(target.index)
+                                                             : local(target, env);
+    }
+
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+        {
+            // A global stays defined once it is, so only the first read needs to check
+            if (expression.getSpecialization() == Specialization::Global)
+            {
+                return *expression.getGlobalSlot();
+            }
+            const Value& value = globals.get(location.index);
+            expression.specialize(Specialization::Global, &value);
+            return value;
+        }
+        case VariableLocation::Kind::Frame:
+            return stack[frameBase + location.index];
+        case VariableLocation::Kind::Cell:
+            return cellAt(location.index).value;
+        default:
+            return env->get(location.index);
     }
-    result = std::make_shared<Result<double>>(-numberResult->getValue());
 }
 
-void Evaluator::visitUnaryExpression(const UnaryExpression& unary, Environment* env)
+Value Evaluator::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
 {
-    result.reset();
-    unary.getRight()->accept(*this, env);
-    const auto& op = unary.getOperator();
+    Value value = visit(*this, ast, expr.getValue(), env);
+    assign(expr.getLocation(), value, env);
+    return value;
+}
 
-    if (op == "!")
-    {
-        handleBangOperator();
-    }
-    else if (op == "-")
+Value Evaluator::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    const auto op   = expr.getOperator();
+    Value      left = visit(*this, ast, expr.getLeft(), env);
+    if (op == LogicalOperator::Or && left.isTruthy())
     {
-        handleMinusOperator();
+        return left;
     }
-    else
+    if (op == LogicalOperator::And && !left.isTruthy())
     {
-        throw EvaluatorError("Unkown unary operator " + op);
+        return left;
     }
+    return visit(*this, ast, expr.getRight(), env);
 }
 
-void Evaluator::handleNumbersOperation(const std::shared_ptr<Result<double>>& leftResult,
-                                       const std::shared_ptr<Result<double>>& rightResult,
-                                       const std::string&                     op)
+Value Evaluator::visitLiteralExpression(const LiteralExpression& literal, Environment* env)
 {
-    auto it = Operators::arithmeticOps.find(op);
-    if (it != Operators::arithmeticOps.end())
-    {
-        handleBinaryOperation<double>(
-            leftResult, rightResult, "Operands must be numbers", it->second);
-        return;
-    }
+    return literal.getConstant();
+}
 
-    auto relIt = Operators::relationalOps.find(op);
-    if (relIt != Operators::relationalOps.end())
-    {
-        handleBinaryOperation<double, bool>(
-            leftResult, rightResult, "Operands must be numbers", relIt->second);
-        return;
-    }
+Value Evaluator::visitUnaryExpression(const UnaryExpression& unary, Environment* env)
+{
+    const auto op      = unary.getOperator();
+    Value      operand = visit(*this, ast, unary.getRight(), env);
 
-    auto eqIt = Operators::equalityOps<double>.find(op);
-    if (eqIt != Operators::equalityOps<double>.end())
+    switch (unary.getSpecialization())
     {
-        handleBinaryOperation<double, bool>(
-            leftResult, rightResult, "Operands must be numbers", eqIt->second);
-        return;
+        case Specialization::Number:
+            if (operand.isNumber())
+            {
+                const double number = operand.asNumber();
+                return op == UnaryOperator::Negate ? Value(-number) : Value(number == 0);
+            }
+            unary.specialize(Specialization::Generic);
+            break;
+        case Specialization::Unobserved:
+            unary.specialize(operand.isNumber() ? Specialization::Number : Specialization::Generic);
+            break;
+        default:
+            break;
     }
+    return Operators::unary(op, operand);
+}
 
-    throw EvaluatorError("Unsupported operator " + op + " for numbers");
+Value Evaluator::visitBinaryExpression(const BinaryExpression& binary, Environment* env)
+{
+    // Operators::binary already takes an inline path for two numbers
+    Value left  = visit(*this, ast, binary.getLeft(), env);
+    Value right = visit(*this, ast, binary.getRight(), env);
+    return Operators::binary(binary.getOperator(), left, right);
 }
 
-void Evaluator::handleStringsOperation(const std::shared_ptr<Result<std::string>>& leftResult,
-                                       const std::shared_ptr<Result<std::string>>& rightResult,
-                                       const std::string&                          op)
+Value Evaluator::visitGroupingExpression(const GroupingExpression& grp, Environment* env)
 {
-    auto eqIt = Operators::equalityOps<std::string>.find(op);
-    if (eqIt != Operators::equalityOps<std::string>.end())
-    {
-        handleBinaryOperation<std::string, bool>(
-            leftResult, rightResult, "Operands must be strings", eqIt->second);
-        return;
-    }
+    return visit(*this, ast, grp.getExpression(), env);
+}
+
+Value Evaluator::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                   Environment*                        env)
+{
+    const auto& location = ast.get<AssignmentExpression>(expr.getAssignment()).getLocation();
+    const auto  op       = expr.getOperator();
+    const auto& operand  = expr.getOperand();
 
-    if (op == "+")
+    // A local number updated by a constant number, like a loop counter, is updated in its slot
+    if (location.kind == VariableLocation::Kind::Frame && operand.constant)
     {
-        handleBinaryOperation<std::string>(
-            leftResult,
-            rightResult,
-            "Operands must be strings",
-            [](const std::string& lhs, const std::string& rhs) { return lhs + rhs; });
-        return;
+        Value& slot = stack[frameBase + location.index];
+        if (Value::areNumbers(slot, *operand.constant))
+        {
+            slot = Value(Operators::arithmetic(op, slot.asNumber(), operand.constant->asNumber()));
+            return slot;
+        }
     }
 
-    throw EvaluatorError("Unsupported operator " + op + " for strings");
+    // The variable is read before the operand is evaluated, which may assign it
+    Value current =
+        Evaluator::visitVariableExpression(ast.get<VariableExpression>(expr.getTarget()), env);
+    Value result  = Operators::binary(op, current, load(operand, env));
+    assign(location, result, env);
+    return result;
 }
 
-void Evaluator::handleBoolsOperation(const std::shared_ptr<Result<bool>>& leftResult,
-                                     const std::shared_ptr<Result<bool>>& rightResult,
-                                     const std::string&                   op)
+Value Evaluator::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
 {
-    auto eqIt = Operators::equalityOps<bool>.find(op);
-    if (eqIt != Operators::equalityOps<bool>.end())
+    Value left  = load(expr.getLeft(), env);
+    Value right = load(expr.getRight(), env);
+    if (Value::areNumbers(left, right))
     {
-        handleBinaryOperation<bool, bool>(
-            leftResult, rightResult, "Operands must be booleans", eqIt->second);
-        return;
+        return Value(Operators::relational(expr.getOperator(), left.asNumber(), right.asNumber()));
     }
-    throw EvaluatorError("Unsupported operator " + op + " for booleans");
+    return Operators::dispatchBinary(expr.getOperator(), left, right);
 }
 
-void Evaluator::handleIncompatibleTypes(const std::string& op)
+Value Evaluator::prepareCall(const CallExpression& expr, Environment* env)
 {
-    if (op == "==" || op == "!=")
-    {
-        result = std::make_unique<Result<bool>>(op == "!=");
-        return;
-    }
-    throw EvaluatorError("Incompatible types for operator " + op);
+    Value callee = visit(*this, ast, expr.getCallee(), env);
+    pushArguments(callee, expr, env);
+    return callee;
 }
 
-void Evaluator::visitBinaryExpression(const BinaryExpression& binary, Environment* env)
+void Evaluator::pushArguments(const Value& callee, const CallExpression& expr, Environment* env)
 {
-    result.reset();
-
-    binary.getLeft()->accept(*this, env);
-    auto leftResult = std::move(result);
-
-    binary.getRight()->accept(*this, env);
-    auto rightResult = std::move(result);
-
-    const auto& op = binary.getOperator();
-
-    // Handle number operators
-    auto leftNum  = std::dynamic_pointer_cast<Result<double>>(leftResult);
-    auto rightNum = std::dynamic_pointer_cast<Result<double>>(rightResult);
-    if (leftNum && rightNum)
+    if (!callee.isCallable())
     {
-        handleNumbersOperation(leftNum, rightNum, op);
-        return;
+        throw EvaluatorError("Attempt to call a non-function object");
     }
 
-    // Handle string operators
-    auto leftString  = std::dynamic_pointer_cast<Result<std::string>>(leftResult);
-    auto rightString = std::dynamic_pointer_cast<Result<std::string>>(rightResult);
-    if (leftString && rightString)
+    // Arguments are pushed on top of the current frame, where they become the callee's parameters
+    const size_t argumentBase = stack.size();
+    for (ExpressionId argument : ast.get(expr.getArguments()))
     {
-        handleStringsOperation(leftString, rightString, op);
-        return;
+        Value value = visit(*this, ast, argument, env);
+        stack.push_back(std::move(value));
     }
 
-    // Handle bools
-    auto leftBool  = std::dynamic_pointer_cast<Result<bool>>(leftResult);
-    auto rightBool = std::dynamic_pointer_cast<Result<bool>>(rightResult);
-    if (leftBool && rightBool)
+    const auto arity = static_cast<const Callable*>(callee.asObject())->arity();
+    if (stack.size() - argumentBase != static_cast<size_t>(arity))
     {
-        handleBoolsOperation(leftBool, rightBool, op);
-        return;
+        throw EvaluatorError("Incorrect number of arguments to function.");
     }
-
-    // Handle incompatible types
-    handleIncompatibleTypes(op);
 }
 
-void Evaluator::visitGroupingExpression(const GroupingExpression& grp, Environment* env)
+Value Evaluator::callArguments(const Value& callee, size_t argumentCount)
 {
-    grp.getExpression()->accept(*this, env);
+    const size_t argumentBase = stack.size() - argumentCount;
+    auto         callable     = static_cast<const Callable*>(callee.asObject());
+
+    Value result = callable->call({stack.data() + argumentBase, argumentCount});
+    stack.resize(argumentBase);
+    return result;
 }
 
-void Evaluator::visitCallExpression(const CallExpression& expr, Environment* env)
+Value Evaluator::visitCallExpression(const CallExpression& expr, Environment* env)
 {
-    result.reset();
-    expr.getCallee()->accept(*this, env);
-    auto callee = std::dynamic_pointer_cast<Callable>(result);
+    Value callee = visit(*this, ast, expr.getCallee(), env);
 
-    if (!callee)
+    if (expr.getSpecialization() == Specialization::Function)
     {
-        throw EvaluatorError("Attempt to call a non-function object");
-    }
+        if (callee.isCallable() &&
+            static_cast<const Callable*>(callee.asObject())->getDefinition() ==
+                expr.getCachedDefinition())
+        {
+            // A Lox function with the same definition as always, whose arity has been checked
+            const size_t argumentBase = stack.size();
+            for (ExpressionId argument : ast.get(expr.getArguments()))
+            {
+                Value value = visit(*this, ast, argument, env);
+                stack.push_back(std::move(value));
+            }
 
-    std::vector<std::shared_ptr<ResultBase>> arguments;
-    for (const auto& argument : expr.getArguments())
-    {
-        argument->accept(*this, env);
-        arguments.push_back(result);
+            Value result = callFunction(*static_cast<const LoxFunction*>(callee.asObject()));
+            stack.resize(argumentBase);
+            return result;
+        }
+        expr.specialize(Specialization::Generic);
     }
 
-    if (arguments.size() != callee->arity())
+    pushArguments(callee, expr, env);
+    if (expr.getSpecialization() == Specialization::Unobserved)
     {
-        throw EvaluatorError("Incorrect number of arguments to function.");
+        const auto* definition = static_cast<const Callable*>(callee.asObject())->getDefinition();
+        expr.specialize(definition ? Specialization::Function : Specialization::Generic, definition);
     }
-
-    result = callee->call(*this, arguments);
+    return callArguments(callee, expr.getArguments().size);
 }
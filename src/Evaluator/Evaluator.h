@@ -3,77 +3,111 @@
 #include <iostream>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <variant>
 
+#include "../Ast/Ast.h"
 #include "../Environment/Environment.h"
 #include "../Expression/ExpressionVisitor.h"
-#include "../Statement/Statement.h"
+#include "../Jit/Jit.h"
 #include "../Statement/StatementVisitor.h"
 
-class Evaluator : public ExpressionVisitor, public StatementVisitor  // Inherit both visitors
+class LoxFunction;
+
+// Tree-walking interpreter. Expressions evaluate to a Value returned directly from each visit
+// method; statements are executed for their effects and report how they completed, so a `return`
+// unwinds to its call by ordinary returns rather than by throwing. Children are evaluated with
+// visit, which switches on the kind in the node's id and calls the method here directly.
+//
+// Locals live in frames on a single value stack: a call pushes its arguments, which become the
+// start of the callee's frame, and the frame is popped on return. A local that a closure captures
+// holds a Cell in its frame slot, shared with the closure's Environment.
+class Evaluator final : public ExpressionVisitor<Value>, public StatementVisitor<Completion>
 {
    public:
-    std::shared_ptr<ResultBase> getResult() { return result; }
+    // Runs the nodes of `ast`. `frameSize` is the number of frame slots the top-level code needs,
+    // from the Resolver.
+    Evaluator(GlobalEnvironment& globals, const Ast& ast, uint32_t frameSize)
+        : globals(globals), ast(ast)
+    {
+        stack.reserve(initialStackSize);
+        stack.resize(frameSize, Value::undefined());
+    }
+
+    // Lets hot functions run as machine code, see Jit.h
+    void enableJit();
+
+    // Runs a function whose arguments are on top of the stack. Tail calls made by the function
+    // reuse its frame.
+    Value callFunction(const LoxFunction& function);
+
     // clang-format off
     // Statement visitor methods
-    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
-    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
-    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
-    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
-    void visitIfStatement(const IfStatement& statement, Environment* env) override;
-    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
-    void visitForStatement(const ForStatement& statement, Environment* env) override;
-    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
-    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+    Completion visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    Completion visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    Completion visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    Completion visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    Completion visitIfStatement(const IfStatement& statement, Environment* env) override;
+    Completion visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    Completion visitForStatement(const ForStatement& statement, Environment* env) override;
+    Completion visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    Completion visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
 
     // Expression visitor methods
-    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
-    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
-    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
-    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
-    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
-    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
-    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
-    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    Value visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    Value visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    Value visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    Value visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    Value visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    Value visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    Value visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    Value visitCallExpression(const CallExpression& expr, Environment* env) override;
+    Value visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    Value visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
     // clang-format on
+
    private:
-    std::shared_ptr<ResultBase> result;
+    static constexpr size_t initialStackSize = 1024;
 
-    void handleIncompatibleTypes(const std::string& op);
+    GlobalEnvironment& globals;
 
-    void handleBangOperator();
-    void handleMinusOperator();
+    const Ast& ast;
 
-    void handleNumbersOperation(const std::shared_ptr<Result<double>>& leftResult,
-                                const std::shared_ptr<Result<double>>& rightResult,
-                                const std::string&                     op);
+    // Set by enableJit
+    std::unique_ptr<Jit> jit;
 
-    void handleStringsOperation(const std::shared_ptr<Result<std::string>>& leftResult,
-                                const std::shared_ptr<Result<std::string>>& rightResult,
-                                const std::string&                          op);
+    std::vector<Value> stack;
 
-    void handleBoolsOperation(const std::shared_ptr<Result<bool>>& leftResult,
-                              const std::shared_ptr<Result<bool>>& rightResult,
-                              const std::string&                   op);
+    // Start of the current function's frame in the stack
+    size_t frameBase = 0;
 
-    template <typename OperandT, typename ReturnT = OperandT, typename Op>
-    void handleBinaryOperation(const std::shared_ptr<ResultBase>& leftResult,
-                               const std::shared_ptr<ResultBase>& rightResult,
-                               const std::string&                 errorMsg,
-                               Op                                 operation)
-    {
-        auto left  = std::dynamic_pointer_cast<Result<OperandT>>(leftResult);
-        auto right = std::dynamic_pointer_cast<Result<OperandT>>(rightResult);
-
-        if (left && right)
-        {
-            result =
-                std::make_unique<Result<ReturnT>>(operation(left->getValue(), right->getValue()));
-        }
-        else
-        {
-            std::cerr << errorMsg << std::endl;
-            std::exit(70);
-        }
-    }
+    // Value of the `return` being completed, taken by the call that handles it
+    Value returnValue;
+
+    // Function of the tail call being completed, whose arguments are on top of the stack
+    Value tailCallee;
+
+    void define(const VariableLocation& location, Value value, Environment* env);
+    void assign(const VariableLocation& location, const Value& value, Environment* env);
+
+    // The location among `location` and its fallbacks that currently holds the variable
+    const VariableLocation& followFallbacks(const VariableLocation& location, Environment* env);
+
+    // Value of a local variable, which may still be undefined
+    const Value& local(const VariableLocation& location, Environment* env);
+
+    // Value of an operand of a fused node
+    Value load(const FusedOperand& operand, Environment* env);
+
+    // Evaluates the callee of `expr` and pushes its arguments, checking them against its arity
+    Value prepareCall(const CallExpression& expr, Environment* env);
+
+    // Checks an already evaluated `callee` and pushes the arguments of `expr`
+    void pushArguments(const Value& callee, const CallExpression& expr, Environment* env);
+
+    // Calls `callee` with the `argumentCount` arguments on top of the stack, then pops them
+    Value callArguments(const Value& callee, size_t argumentCount);
+
+    // Cell of the captured local at frame slot `index`, created if its declaration has not run
+    Cell& cellAt(uint32_t index);
 };
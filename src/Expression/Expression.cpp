@@ -0,0 +1,60 @@
+#include "Expression.h"
+
+#include "../Ast/Ast.h"
+
+FusedOperand::FusedOperand(const Ast& ast, ExpressionId expression) : expression(expression)
+{
+    if (expression.kind() == ExpressionKind::Literal)
+    {
+        constant = &ast.get<LiteralExpression>(expression).getConstant();
+    }
+}
+
+CompoundAssignmentExpression::CompoundAssignmentExpression(const Ast& ast, ExpressionId assignment)
+    : CompoundAssignmentExpression(
+          ast,
+          assignment,
+          ast.get<BinaryExpression>(ast.get<AssignmentExpression>(assignment).getValue()))
+{
+}
+
+CompoundAssignmentExpression::CompoundAssignmentExpression(const Ast&              ast,
+                                                           ExpressionId            assignment,
+                                                           const BinaryExpression& binary)
+    : assignment(assignment),
+      target(binary.getLeft()),
+      op(binary.getOperator()),
+      operand(ast, binary.getRight())
+{
+}
+
+bool CompoundAssignmentExpression::match(const Ast& ast, const AssignmentExpression& assignment)
+{
+    if (assignment.getValue().kind() != ExpressionKind::Binary)
+    {
+        return false;
+    }
+    const auto& binary = ast.get<BinaryExpression>(assignment.getValue());
+    return Operators::isArithmetic(binary.getOperator()) &&
+           binary.getLeft().kind() == ExpressionKind::Variable &&
+           ast.get<VariableExpression>(binary.getLeft()).getName() == assignment.getName();
+}
+
+ComparisonExpression::ComparisonExpression(const Ast& ast, ExpressionId comparison)
+    : comparison(comparison),
+      op(ast.get<BinaryExpression>(comparison).getOperator()),
+      left(ast, ast.get<BinaryExpression>(comparison).getLeft()),
+      right(ast, ast.get<BinaryExpression>(comparison).getRight())
+{
+}
+
+bool ComparisonExpression::match(const BinaryExpression& comparison)
+{
+    const auto isLeaf = [](ExpressionId operand)
+    {
+        return operand.kind() == ExpressionKind::Literal ||
+               operand.kind() == ExpressionKind::Variable;
+    };
+    return Operators::isRelational(comparison.getOperator()) && isLeaf(comparison.getLeft()) &&
+           isLeaf(comparison.getRight());
+}
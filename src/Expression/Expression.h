@@ -1,23 +1,55 @@
 #pragma once
-#include <memory>
-#include <string>
-#include <vector>
+#include <cstdint>
 
+#include "../Ast/NodeId.h"
 #include "../Environment/Environment.h"
-#include "../Token/Token.h"
-#include "ExpressionVisitor.h"
+#include "../Operators/Operators.h"
+#include "../Value/Value.h"
 
-// Abstract base class for expressions
-class Expression
+class Ast;
+struct FunctionPrototype;
+
+// Concrete type of an expression node. The set of nodes is closed, so code that visits them can
+// switch on the kind instead of making virtual calls, see visit in Ast.h.
+enum class ExpressionKind : uint8_t
 {
-   public:
-    virtual ~Expression() = default;
+    Literal,
+    Grouping,
+    Unary,
+    Binary,
+    Variable,
+    Assignment,
+    Logical,
+    Call,
+    CompoundAssignment,
+    Comparison
+};
+
+// Base of the expression nodes. A node is stored by value in the vector of its kind in an Ast,
+// and refers to its children and names by id, so it holds no pointer to other nodes and owns
+// nothing that needs freeing on its own.
+template <ExpressionKind Kind>
+struct ExpressionNode
+{
+    using Id = ExpressionId;
+
+    static constexpr ExpressionKind kind = Kind;
+};
 
-    virtual void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const = 0;
+// What a node has specialized itself to, based on the operand types the Evaluator observed the
+// first time it ran. A specialized node checks its assumption on every run and falls back to
+// Generic for good once it fails.
+enum class Specialization : uint8_t
+{
+    Unobserved,
+    Number,    // Operands are numbers
+    Function,  // Callee is always the same function
+    Global,    // Global variable is known to be defined
+    Generic
 };
 
 // Enum to represent the type of a literal
-enum class LiteralType
+enum class LiteralType : uint8_t
 {
     Number,
     String,
@@ -25,173 +57,235 @@ enum class LiteralType
     Nil
 };
 
-class LiteralExpression : public Expression
+// A literal keeps its source text for printing, and the runtime Value it was converted to at parse
+// time, which lives in the program's ConstantPool.
+class LiteralExpression : public ExpressionNode<ExpressionKind::Literal>
 {
    public:
-    LiteralExpression(const std::string& value, LiteralType type) : value(value), type(type) {}
-
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
+    LiteralExpression(NameId text, LiteralType type, const Value& constant)
+        : text(text), type(type), constant(&constant)
     {
-        visitor.visitLiteralExpression(*this, env);
     }
 
-    const std::string& getValue() const { return value; }
-    LiteralType        getType() const { return type; }
+    NameId       getText() const { return text; }
+    LiteralType  getType() const { return type; }
+    const Value& getConstant() const { return *constant; }
 
    private:
-    const std::string value;
-    const LiteralType type;
+    NameId       text;
+    LiteralType  type;
+    const Value* constant;
 };
 
 // Concrete subclass for grouping expressions
-class GroupingExpression : public Expression
+class GroupingExpression : public ExpressionNode<ExpressionKind::Grouping>
 {
    public:
-    explicit GroupingExpression(std::unique_ptr<Expression> expression)
-        : expression(std::move(expression))
-    {
-    }
+    explicit GroupingExpression(ExpressionId expression) : expression(expression) {}
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitGroupingExpression(*this, env);
-    }
-
-    const Expression* getExpression() const { return expression.get(); }
+    ExpressionId getExpression() const { return expression; }
 
    private:
-    std::unique_ptr<Expression> expression;
+    ExpressionId expression;
 };
 
 // Concrete class for unary expressions
-class UnaryExpression : public Expression
+class UnaryExpression : public ExpressionNode<ExpressionKind::Unary>
 {
    public:
-    UnaryExpression(const std::string& op, std::unique_ptr<Expression> right)
-        : op(op), right(std::move(right))
-    {
-    }
+    UnaryExpression(UnaryOperator op, ExpressionId right) : op(op), right(right) {}
 
-    const std::string& getOperator() const { return op; }
-    const Expression*  getRight() const { return right.get(); }
+    UnaryOperator getOperator() const { return op; }
+    ExpressionId  getRight() const { return right; }
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitUnaryExpression(*this, env);
-    }
+    // Rewritten by the Evaluator as it runs
+    Specialization getSpecialization() const { return specialization; }
+    void           specialize(Specialization observed) const { specialization = observed; }
 
    private:
-    const std::string                 op;
-    const std::unique_ptr<Expression> right;
+    UnaryOperator op;
+    ExpressionId  right;
+
+    mutable Specialization specialization = Specialization::Unobserved;
 };
 
 // Concrete subclass for binary expressions
-class BinaryExpression : public Expression
+class BinaryExpression : public ExpressionNode<ExpressionKind::Binary>
 {
    public:
-    BinaryExpression(std::unique_ptr<Expression> left,
-                     const std::string&          op,
-                     std::unique_ptr<Expression> right)
-        : left(std::move(left)), op(op), right(std::move(right))
-    {
-    }
-
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
+    BinaryExpression(ExpressionId left, BinaryOperator op, ExpressionId right)
+        : left(left), op(op), right(right)
     {
-        visitor.visitBinaryExpression(*this, env);
     }
 
-    const Expression*  getLeft() const { return left.get(); }
-    const std::string& getOperator() const { return op; }
-    const Expression*  getRight() const { return right.get(); }
+    ExpressionId   getLeft() const { return left; }
+    BinaryOperator getOperator() const { return op; }
+    ExpressionId   getRight() const { return right; }
 
    private:
-    const std::unique_ptr<Expression> left;
-    const std::string                 op;
-    const std::unique_ptr<Expression> right;
+    ExpressionId   left;
+    BinaryOperator op;
+    ExpressionId   right;
 };
 
-class VariableExpression : public Expression
+class VariableExpression : public ExpressionNode<ExpressionKind::Variable>
 {
    public:
-    explicit VariableExpression(const std::string& name) : name(name) {}
+    explicit VariableExpression(NameId name) : name(name) {}
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
+    NameId getName() const { return name; }
+
+    // Set by the Resolver before the expression is evaluated
+    const VariableLocation& getLocation() const { return location; }
+    void                    resolve(const VariableLocation& resolved) const { location = resolved; }
+
+    // Rewritten by the Evaluator as it runs. A Global node reads its defined slot directly.
+    Specialization getSpecialization() const { return specialization; }
+    const Value*   getGlobalSlot() const { return globalSlot; }
+    void           specialize(Specialization observed, const Value* slot = nullptr) const
     {
-        visitor.visitVariableExpression(*this, env);
+        specialization = observed;
+        globalSlot     = slot;
     }
 
-    const std::string& getName() const { return name; }
-
    private:
-    const std::string name;
+    NameId name;
+
+    mutable VariableLocation location;
+
+    mutable Specialization specialization = Specialization::Unobserved;
+    mutable const Value*   globalSlot     = nullptr;
 };
 
-class AssignmentExpression : public Expression
+class AssignmentExpression : public ExpressionNode<ExpressionKind::Assignment>
 {
    public:
-    AssignmentExpression(std::string name, std::unique_ptr<Expression> value)
-        : name(std::move(name)), value(std::move(value))
-    {
-    }
+    AssignmentExpression(NameId name, ExpressionId value) : name(name), value(value) {}
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitAssignmentExpression(*this, env);
-    }
+    NameId       getName() const { return name; }
+    ExpressionId getValue() const { return value; }
 
-    const std::string& getName() const { return name; }
-    const Expression*  getValue() const { return value.get(); }
+    // Set by the Resolver before the expression is evaluated
+    const VariableLocation& getLocation() const { return location; }
+    void                    resolve(const VariableLocation& resolved) const { location = resolved; }
 
    private:
-    const std::string                 name;
-    const std::unique_ptr<Expression> value;
+    NameId       name;
+    ExpressionId value;
+
+    mutable VariableLocation location;
 };
 
-class LogicalExpression : public Expression
+class LogicalExpression : public ExpressionNode<ExpressionKind::Logical>
 {
    public:
-    LogicalExpression(std::unique_ptr<Expression> left,
-                      const std::string&          operatorLexeme,
-                      std::unique_ptr<Expression> right)
-        : left(std::move(left)), operatorLexeme(operatorLexeme), right(std::move(right))
+    LogicalExpression(ExpressionId left, LogicalOperator op, ExpressionId right)
+        : left(left), op(op), right(right)
     {
     }
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitLogicalExpression(*this, env);
-    }
-
-    const Expression*  getLeft() const { return left.get(); }
-    const std::string& getOperator() const { return operatorLexeme; }
-    const Expression*  getRight() const { return right.get(); }
+    ExpressionId    getLeft() const { return left; }
+    LogicalOperator getOperator() const { return op; }
+    ExpressionId    getRight() const { return right; }
 
    private:
-    const std::unique_ptr<Expression> left;
-    const std::string                 operatorLexeme;
-    const std::unique_ptr<Expression> right;
+    ExpressionId    left;
+    LogicalOperator op;
+    ExpressionId    right;
 };
 
-class CallExpression : public Expression
+class CallExpression : public ExpressionNode<ExpressionKind::Call>
 {
    public:
-    CallExpression(std::unique_ptr<Expression>              callee,
-                   std::vector<std::unique_ptr<Expression>> arguments)
-        : callee(std::move(callee)), arguments(std::move(arguments))
+    CallExpression(ExpressionId callee, IdList<ExpressionId> arguments)
+        : callee(callee), arguments(arguments)
     {
     }
 
-    void accept(ExpressionVisitor& visitor, Environment* env = nullptr) const override
+    ExpressionId         getCallee() const { return callee; }
+    IdList<ExpressionId> getArguments() const { return arguments; }
+
+    // Rewritten by the Evaluator as it runs. A Function node records the definition of the
+    // functions it has always called, whose arity matches the arguments. Holding the definition
+    // rather than a function keeps no closure alive, and any closure created from it will do.
+    Specialization           getSpecialization() const { return specialization; }
+    const FunctionPrototype* getCachedDefinition() const { return cachedDefinition; }
+    void specialize(Specialization observed, const FunctionPrototype* definition = nullptr) const
     {
-        visitor.visitCallExpression(*this, env);
+        specialization   = observed;
+        cachedDefinition = definition;
     }
 
-    const Expression* getCallee() const { return callee.get(); }
+   private:
+    ExpressionId         callee;
+    IdList<ExpressionId> arguments;
+
+    mutable Specialization           specialization   = Specialization::Unobserved;
+    mutable const FunctionPrototype* cachedDefinition = nullptr;
+};
+
+// Operand of a fused node. The value of a literal is recorded, and a variable can be told from
+// its id, so the Evaluator can read either without dispatching on the node.
+struct FusedOperand
+{
+    FusedOperand(const Ast& ast, ExpressionId expression);
+
+    bool isVariable() const { return expression.kind() == ExpressionKind::Variable; }
+
+    ExpressionId expression;
+    const Value* constant = nullptr;
+};
+
+// `name = name op operand` with an arithmetic operator, such as an increment or an accumulation.
+// Fused by the Optimizer so the Evaluator updates the variable in place. It keeps the assignment
+// it replaces, which the other visitors handle instead.
+class CompoundAssignmentExpression : public ExpressionNode<ExpressionKind::CompoundAssignment>
+{
+   public:
+    // `assignment` must have that shape, see match
+    CompoundAssignmentExpression(const Ast& ast, ExpressionId assignment);
+
+    // Whether `assignment` can be fused
+    static bool match(const Ast& ast, const AssignmentExpression& assignment);
+
+    ExpressionId        getAssignment() const { return assignment; }
+    BinaryOperator      getOperator() const { return op; }
+    const FusedOperand& getOperand() const { return operand; }
+
+    // The read of the variable, which resolves to the same location as the assignment
+    ExpressionId getTarget() const { return target; }
+
+   private:
+    CompoundAssignmentExpression(const Ast&              ast,
+                                 ExpressionId            assignment,
+                                 const BinaryExpression& binary);
+
+    ExpressionId   assignment;
+    ExpressionId   target;
+    BinaryOperator op;
+    FusedOperand   operand;
+};
+
+// `left op right` with a relational operator and operands that are each a literal or a variable,
+// such as a loop condition. Fused by the Optimizer so the Evaluator compares the operands
+// directly. It keeps the comparison it replaces, which the other visitors handle instead.
+class ComparisonExpression : public ExpressionNode<ExpressionKind::Comparison>
+{
+   public:
+    // `comparison` must have that shape, see match
+    ComparisonExpression(const Ast& ast, ExpressionId comparison);
+
+    // Whether `comparison` can be fused
+    static bool match(const BinaryExpression& comparison);
 
-    const std::vector<std::unique_ptr<Expression>>& getArguments() const { return arguments; }
+    ExpressionId        getComparison() const { return comparison; }
+    BinaryOperator      getOperator() const { return op; }
+    const FusedOperand& getLeft() const { return left; }
+    const FusedOperand& getRight() const { return right; }
 
    private:
-    const std::unique_ptr<Expression>              callee;
-    const std::vector<std::unique_ptr<Expression>> arguments;
+    ExpressionId   comparison;
+    BinaryOperator op;
+    FusedOperand   left;
+    FusedOperand   right;
 };
@@ -11,22 +11,28 @@ class VariableExpression;
 class AssignmentExpression;
 class LogicalExpression;
 class CallExpression;
+class CompoundAssignmentExpression;
+class ComparisonExpression;
 
+// Visitors return their result directly, so an evaluator can keep intermediate values on the
+// stack instead of threading them through shared state. A node is passed to the method for its
+// type by visit, see Ast.h.
+template <typename R>
 class ExpressionVisitor
 {
    public:
-    virtual void visitLiteralExpression(const LiteralExpression& expr,
-                                        Environment*             env = nullptr)                            = 0;
-    virtual void visitGroupingExpression(const GroupingExpression& expr,
-                                         Environment*              env = nullptr)                           = 0;
-    virtual void visitBinaryExpression(const BinaryExpression& expr,
-                                       Environment*            env = nullptr)                             = 0;
-    virtual void visitUnaryExpression(const UnaryExpression& expr, Environment* env = nullptr) = 0;
-    virtual void visitVariableExpression(const VariableExpression& expr,
-                                         Environment*              env = nullptr)                           = 0;
-    virtual void visitAssignmentExpression(const AssignmentExpression& expr,
-                                           Environment*                env = nullptr)                         = 0;
-    virtual void visitLogicalExpression(const LogicalExpression& expr,
-                                        Environment*             env = nullptr)                            = 0;
-    virtual void visitCallExpression(const CallExpression& expr, Environment* env = nullptr)   = 0;
+    virtual ~ExpressionVisitor() = default;
+
+    // clang-format off
+    virtual R visitLiteralExpression(const LiteralExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitGroupingExpression(const GroupingExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitBinaryExpression(const BinaryExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitUnaryExpression(const UnaryExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitVariableExpression(const VariableExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitAssignmentExpression(const AssignmentExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitLogicalExpression(const LogicalExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitCallExpression(const CallExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env = nullptr) = 0;
+    virtual R visitComparisonExpression(const ComparisonExpression& expr, Environment* env = nullptr) = 0;
+    // clang-format on
 };
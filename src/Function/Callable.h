@@ -1,17 +1,23 @@
 #pragma once
-#include <memory>
-#include <vector>
+#include <span>
 
-#include "../Evaluator/Evaluator.h"
-#include "../Result/Result.h"
+#include "../Value/Value.h"
 
-class Callable : public ResultBase
+struct FunctionPrototype;
+
+// A function value. Calls pass their arguments as a view of the calling engine's stack; functions
+// defined in Lox know the engine that created them.
+class Callable : public Object
 {
    public:
+    Callable() : Object(Kind::Callable) {}
+
     virtual int arity() const = 0;
 
-    virtual std::shared_ptr<ResultBase> call(
-        Evaluator& evaluator, std::vector<std::shared_ptr<ResultBase>> arguments) const = 0;
+    virtual Value call(std::span<Value> arguments) const = 0;
+
+    // Definition of a function the Evaluator created, or null for any other callable
+    virtual const FunctionPrototype* getDefinition() const { return nullptr; }
 
     virtual ~Callable() = default;
 };
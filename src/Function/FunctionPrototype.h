@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Ast/NodeId.h"
+#include "../Environment/Environment.h"
+#include "../Jit/JitState.h"
+
+// What every closure created from a function definition shares. It is built once, with the
+// definition at parse time, and the Resolver fills in the frame layout; running the `fun`
+// statement only creates a LoxFunction that refers to it and holds the captured Cells.
+struct FunctionPrototype
+{
+    FunctionPrototype(const std::string& name, uint32_t parameterCount, StatementId body)
+        : name(name), parameterCount(parameterCount), body(body)
+    {
+    }
+
+    // Interned in the Ast, like the body, which is a block
+    const std::string& name;
+    uint32_t           parameterCount;
+    StatementId        body;
+
+    // Set by the Resolver: the layout of the scope a call creates for the parameters and the frame
+    // slot of each parameter in it, the number of frame slots a call needs, and the variables a
+    // closure of the function captures
+    ScopeLayout           parameterScope;
+    std::vector<uint32_t> parameterSlots;
+    uint32_t              frameSize = 0;
+    std::vector<Capture>  captures;
+
+    // Tier-up state under --jit, shared by every closure of the definition. Compiled code never
+    // touches captured variables, so it runs the same for all of them.
+    mutable JitState jitState;
+
+    int arity() const { return static_cast<int>(parameterCount); }
+};
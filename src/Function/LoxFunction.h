@@ -4,28 +4,49 @@
 #include "../Evaluator/Evaluator.h"
 #include "../Statement/Statement.h"
 #include "Callable.h"
-#include "ReturnException.h"
 
 class LoxFunction : public Callable
 {
    public:
-    explicit LoxFunction(const std::shared_ptr<FunctionDefinitionStatement>& def,
-                         std::shared_ptr<Environment>                        closure)
-        : definition(std::move(def)), closure(std::move(closure))
+    LoxFunction(const FunctionPrototype&     prototype,
+                std::unique_ptr<Environment> closure,
+                Evaluator&                   evaluator)
+        : prototype(prototype), closure(std::move(closure)), evaluator(evaluator)
     {
+        if (this->closure)
+        {
+            Collector::track(*this);
+        }
     }
 
-    std::shared_ptr<ResultBase> call(
-        Evaluator& evaluator, std::vector<std::shared_ptr<ResultBase>> arguments) const override;
+    Value call(std::span<Value> arguments) const override;
 
-    int arity() const override { return definition->getParameters().size(); }  // No parameters
+    int arity() const override { return prototype.arity(); }
+
+    const FunctionPrototype* getDefinition() const override { return &prototype; }
 
     bool isTruthy() const override { return false; }
 
-    void print() const override { std::cout << "<fn " + definition->getName() + ">" << std::endl; }
+    void print() const override { std::cout << "<fn " + prototype.name + ">" << std::endl; }
+
+    void references(std::vector<Object*>& referenced) const override
+    {
+        if (closure)
+        {
+            closure->references(referenced);
+        }
+    }
+    void clearReferences() override { closure.reset(); }
+
+    const FunctionPrototype& getPrototype() const { return prototype; }
+    Environment*             getClosure() const { return closure.get(); }
 
    private:
-    std::shared_ptr<FunctionDefinitionStatement> definition;
+    // Owned by the definition in the AST, which outlives every function created from it
+    const FunctionPrototype& prototype;
+
+    // Captured variables, or null if the function captures none
+    std::unique_ptr<Environment> closure;
 
-    std::shared_ptr<Environment> closure;
+    Evaluator& evaluator;
 };
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Statement/StatementVisitor.h"
+
+// Runs a call to `function`, whose arguments start at `base` on top of `stack`. `runBody` runs the
+// body of the function being called once its frame is entered, and returns how it completed. A
+// body that completes with a tail call leaves its callee in `tailCallee` and the arguments on top
+// of the stack: they are moved down to `base` and the callee runs in place of the frame.
+//
+// Shared by the Evaluator and the closure-compilation engine, whose functions both expose the
+// Resolver's frame layout through getPrototype().
+template <typename Function, typename RunBody>
+Completion runCall(std::vector<Value>& stack,
+                   size_t              base,
+                   const Function&     function,
+                   Value&              tailCallee,
+                   RunBody&&           runBody)
+{
+    const Function* current = &function;
+    Value           callee;  // Keeps the function of a tail call alive while it runs
+
+    while (true)
+    {
+        const auto& prototype = current->getPrototype();
+        enterFrame(stack,
+                   base,
+                   prototype.parameterSlots,
+                   prototype.parameterScope,
+                   prototype.frameSize);
+
+        const Completion completion = runBody(*current);
+        if (completion != Completion::TailCall)
+        {
+            return completion;
+        }
+
+        callee  = std::move(tailCallee);
+        current = static_cast<const Function*>(callee.asObject());
+
+        const size_t nextCount    = current->arity();
+        const size_t argumentBase = stack.size() - nextCount;
+        for (size_t i = 0; i < nextCount; ++i)
+        {
+            stack[base + i] = std::move(stack[argumentBase + i]);
+        }
+        stack.resize(base + nextCount);
+    }
+}
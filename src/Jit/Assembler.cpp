@@ -0,0 +1,236 @@
+#include "Assembler.h"
+
+namespace x64
+{
+
+namespace
+{
+
+uint8_t code(Register reg)
+{
+    return static_cast<uint8_t>(reg);
+}
+
+uint8_t code(Xmm reg)
+{
+    return static_cast<uint8_t>(reg);
+}
+
+}  // namespace
+
+void Assembler::emit32(uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        emit(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void Assembler::emit64(uint64_t value)
+{
+    emit32(static_cast<uint32_t>(value));
+    emit32(static_cast<uint32_t>(value >> 32));
+}
+
+void Assembler::rexW(uint8_t reg, uint8_t rm)
+{
+    emit(0x48 | ((reg >> 3) << 2) | (rm >> 3));
+}
+
+void Assembler::memory(uint8_t reg, Register base, int32_t displacement)
+{
+    emit(0x80 | ((reg & 7) << 3) | (code(base) & 7));
+    if ((code(base) & 7) == code(Register::Rsp))
+    {
+        emit(0x24);  // SIB: no index
+    }
+    emit32(static_cast<uint32_t>(displacement));
+}
+
+void Assembler::push(Register reg)
+{
+    if (code(reg) >= 8) emit(0x41);
+    emit(0x50 | (code(reg) & 7));
+}
+
+void Assembler::pop(Register reg)
+{
+    if (code(reg) >= 8) emit(0x41);
+    emit(0x58 | (code(reg) & 7));
+}
+
+void Assembler::mov(Register dst, Register src)
+{
+    rexW(code(src), code(dst));
+    emit(0x89);
+    emit(0xC0 | ((code(src) & 7) << 3) | (code(dst) & 7));
+}
+
+void Assembler::mov(Register dst, uint64_t immediate)
+{
+    rexW(0, code(dst));
+    emit(0xB8 | (code(dst) & 7));
+    emit64(immediate);
+}
+
+void Assembler::mov32(Register dst, uint32_t immediate)
+{
+    if (code(dst) >= 8) emit(0x41);
+    emit(0xB8 | (code(dst) & 7));
+    emit32(immediate);
+}
+
+void Assembler::load(Register dst, Register base, int32_t displacement)
+{
+    rexW(code(dst), code(base));
+    emit(0x8B);
+    memory(code(dst), base, displacement);
+}
+
+void Assembler::lea(Register dst, Register base, int32_t displacement)
+{
+    rexW(code(dst), code(base));
+    emit(0x8D);
+    memory(code(dst), base, displacement);
+}
+
+void Assembler::add(Register dst, int32_t immediate)
+{
+    rexW(0, code(dst));
+    emit(0x81);
+    emit(0xC0 | (code(dst) & 7));
+    emit32(static_cast<uint32_t>(immediate));
+}
+
+void Assembler::sub(Register dst, int32_t immediate)
+{
+    rexW(0, code(dst));
+    emit(0x81);
+    emit(0xE8 | (code(dst) & 7));
+    emit32(static_cast<uint32_t>(immediate));
+}
+
+void Assembler::cmp(Register lhs, Register rhs)
+{
+    rexW(code(rhs), code(lhs));
+    emit(0x39);
+    emit(0xC0 | ((code(rhs) & 7) << 3) | (code(lhs) & 7));
+}
+
+void Assembler::testLowByte(Register reg)
+{
+    // Only valid for the registers whose low byte needs no REX prefix
+    emit(0x84);
+    emit(0xC0 | (code(reg) << 3) | code(reg));
+}
+
+void Assembler::call(Register target)
+{
+    if (code(target) >= 8) emit(0x41);
+    emit(0xFF);
+    emit(0xD0 | (code(target) & 7));
+}
+
+void Assembler::ret()
+{
+    emit(0xC3);
+}
+
+void Assembler::loadDouble(Xmm dst, Register base, int32_t displacement)
+{
+    emit(0xF2);
+    if (code(base) >= 8) emit(0x41);
+    emit(0x0F);
+    emit(0x10);
+    memory(code(dst), base, displacement);
+}
+
+void Assembler::storeDouble(Register base, int32_t displacement, Xmm src)
+{
+    emit(0xF2);
+    if (code(base) >= 8) emit(0x41);
+    emit(0x0F);
+    emit(0x11);
+    memory(code(src), base, displacement);
+}
+
+void Assembler::movq(Xmm dst, Register src)
+{
+    emit(0x66);
+    rexW(code(dst), code(src));
+    emit(0x0F);
+    emit(0x6E);
+    emit(0xC0 | (code(dst) << 3) | (code(src) & 7));
+}
+
+void Assembler::movsd(Xmm dst, Xmm src)
+{
+    emit(0xF2);
+    emit(0x0F);
+    emit(0x10);
+    emit(0xC0 | (code(dst) << 3) | code(src));
+}
+
+void Assembler::arithmetic(Arithmetic op, Xmm dst, Xmm src)
+{
+    emit(0xF2);
+    emit(0x0F);
+    emit(static_cast<uint8_t>(op));
+    emit(0xC0 | (code(dst) << 3) | code(src));
+}
+
+void Assembler::xorpd(Xmm dst, Xmm src)
+{
+    emit(0x66);
+    emit(0x0F);
+    emit(0x57);
+    emit(0xC0 | (code(dst) << 3) | code(src));
+}
+
+void Assembler::ucomisd(Xmm lhs, Xmm rhs)
+{
+    emit(0x66);
+    emit(0x0F);
+    emit(0x2E);
+    emit(0xC0 | (code(lhs) << 3) | code(rhs));
+}
+
+void Assembler::jump(Label& label)
+{
+    emit(0xE9);
+    jumpTo(label);
+}
+
+void Assembler::jump(Condition condition, Label& label)
+{
+    emit(0x0F);
+    emit(0x80 | static_cast<uint8_t>(condition));
+    jumpTo(label);
+}
+
+void Assembler::jumpTo(Label& label)
+{
+    if (label.position != Label::unbound)
+    {
+        emit32(static_cast<uint32_t>(label.position - (bytes.size() + 4)));
+        return;
+    }
+    label.uses.push_back(bytes.size());
+    emit32(0);
+}
+
+void Assembler::bind(Label& label)
+{
+    label.position = bytes.size();
+    for (const size_t use : label.uses)
+    {
+        const auto offset = static_cast<uint32_t>(label.position - (use + 4));
+        for (int i = 0; i < 4; ++i)
+        {
+            bytes[use + i] = static_cast<uint8_t>(offset >> (8 * i));
+        }
+    }
+    label.uses.clear();
+}
+
+}  // namespace x64
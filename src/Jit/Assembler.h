@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal x86-64 encoder for the Jit: the handful of general purpose and SSE2 scalar double
+// instructions its code generator needs. Every memory operand uses a 32-bit displacement, and
+// every jump a 32-bit offset, so the encodings stay uniform.
+namespace x64
+{
+
+enum class Register : uint8_t
+{
+    Rax = 0,
+    Rcx = 1,
+    Rdx = 2,
+    Rbx = 3,
+    Rsp = 4,
+    Rbp = 5,
+    Rsi = 6,
+    Rdi = 7,
+    R13 = 13
+};
+
+// Only the low SSE registers are used, so no REX prefix is ever needed for them
+enum class Xmm : uint8_t
+{
+    Xmm0 = 0,
+    Xmm1 = 1,
+    Xmm2 = 2
+};
+
+// Condition codes of Jcc, as read after ucomisd
+enum class Condition : uint8_t
+{
+    Below      = 0x2,
+    AboveEqual = 0x3,
+    Equal      = 0x4,
+    NotEqual   = 0x5,
+    BelowEqual = 0x6,
+    Above      = 0x7,
+    Parity     = 0xA
+};
+
+// Scalar double arithmetic, by opcode
+enum class Arithmetic : uint8_t
+{
+    Add      = 0x58,
+    Multiply = 0x59,
+    Subtract = 0x5C,
+    Divide   = 0x5E
+};
+
+// A jump target. Jumps to a label that is not bound yet are patched when it is.
+struct Label
+{
+    static constexpr size_t unbound = SIZE_MAX;
+
+    size_t              position = unbound;
+    std::vector<size_t> uses;
+};
+
+class Assembler
+{
+   public:
+    const std::vector<uint8_t>& getCode() const { return bytes; }
+
+    void push(Register reg);
+    void pop(Register reg);
+    void mov(Register dst, Register src);
+    void mov(Register dst, uint64_t immediate);
+    void mov32(Register dst, uint32_t immediate);
+    void load(Register dst, Register base, int32_t displacement);
+    void lea(Register dst, Register base, int32_t displacement);
+    void add(Register dst, int32_t immediate);
+    void sub(Register dst, int32_t immediate);
+    void cmp(Register lhs, Register rhs);
+    void testLowByte(Register reg);
+    void call(Register target);
+    void ret();
+
+    void loadDouble(Xmm dst, Register base, int32_t displacement);
+    void storeDouble(Register base, int32_t displacement, Xmm src);
+    void movq(Xmm dst, Register src);
+    void movsd(Xmm dst, Xmm src);
+    void arithmetic(Arithmetic op, Xmm dst, Xmm src);
+    void xorpd(Xmm dst, Xmm src);
+    void ucomisd(Xmm lhs, Xmm rhs);
+
+    void jump(Label& label);
+    void jump(Condition condition, Label& label);
+    void bind(Label& label);
+
+   private:
+    std::vector<uint8_t> bytes;
+
+    void emit(uint8_t byte) { bytes.push_back(byte); }
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+
+    // REX prefix for a 64-bit operation on `reg` and the base or r/m register `rm`
+    void rexW(uint8_t reg, uint8_t rm);
+
+    // ModRM byte (and SIB where the base needs one) plus displacement of [base + displacement]
+    void memory(uint8_t reg, Register base, int32_t displacement);
+
+    void jumpTo(Label& label);
+};
+
+}  // namespace x64
@@ -0,0 +1,126 @@
+#include "Jit.h"
+
+#include <cstring>
+
+#include "../Function/LoxFunction.h"
+#include "JitCompiler.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define LOX_JIT_SUPPORTED 1
+#endif
+
+Jit::~Jit()
+{
+#ifdef LOX_JIT_SUPPORTED
+    for (const auto& mapping : mappings)
+    {
+        munmap(mapping.data(), mapping.size());
+    }
+#endif
+}
+
+bool Jit::tryCall(const LoxFunction& function, std::span<const Value> arguments, Value& result)
+{
+    JitState& state = function.getPrototype().jitState;
+    if (state.status == JitState::Status::Rejected)
+    {
+        return false;
+    }
+    if (state.status == JitState::Status::Interpreted &&
+        (++state.callCount < callThreshold || !compile(function)))
+    {
+        return false;
+    }
+
+    // Guard: compiled code only handles numbers
+    double reversed[maxParameters];
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        if (!arguments[i].isNumber())
+        {
+            return false;
+        }
+        reversed[arguments.size() - 1 - i] = arguments[i].asNumber();
+    }
+
+    double number;
+    if (!state.code(reversed, &number))
+    {
+        if (++state.bailoutCount >= bailoutLimit)
+        {
+            state.status = JitState::Status::Rejected;
+        }
+        return false;
+    }
+    result = Value(number);
+    return true;
+}
+
+bool Jit::compile(const LoxFunction& function)
+{
+    JitState& state = function.getPrototype().jitState;
+    state.status    = JitState::Status::Rejected;
+
+#ifdef LOX_JIT_SUPPORTED
+    const size_t               guarded = guardedFunctions.size();
+    JitCompiler                compiler(*this, ast, function);
+    const std::vector<uint8_t> code = compiler.compile();
+    if (code.empty())
+    {
+        guardedFunctions.erase(guardedFunctions.begin() + guarded, guardedFunctions.end());
+        return false;
+    }
+
+    // Written while writable, then made executable, so no page is ever both
+    void* memory =
+        mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, code.size());
+        return false;
+    }
+    mappings.emplace_back(static_cast<std::byte*>(memory), code.size());
+
+    state.code   = reinterpret_cast<NativeCode>(memory);
+    state.status = JitState::Status::Compiled;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Jit::callFromNative(Jit*          jit,
+                         uint32_t      globalIndex,
+                         uint32_t      argumentCount,
+                         const double* arguments)
+{
+    if (!jit->globals.isDefined(globalIndex))
+    {
+        return false;
+    }
+
+    const Value& callee = jit->globals.get(globalIndex);
+    if (!callee.isCallable())
+    {
+        return false;
+    }
+    const auto* function = dynamic_cast<const LoxFunction*>(callee.asObject());
+    if (!function || function->arity() != static_cast<int>(argumentCount))
+    {
+        return false;
+    }
+
+    // A callee that is not hot yet is compiled right away: the interpreter cannot run it from here
+    JitState& state = function->getPrototype().jitState;
+    if (state.status == JitState::Status::Interpreted)
+    {
+        jit->compile(*function);
+    }
+    return state.status == JitState::Status::Compiled && state.code(arguments, &jit->callResult);
+}
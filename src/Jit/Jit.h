@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Value/Value.h"
+
+class Ast;
+class LoxFunction;
+
+// Baseline compiler from Lox functions to x86-64 machine code, used by the Evaluator under --jit.
+//
+// Only pure numeric functions are compiled: their parameters and locals are numbers, they do
+// nothing but arithmetic, comparisons, control flow and calls to other such functions, and they
+// have no effect other than their result. Compiled code checks its assumptions as it runs (the
+// arguments and every call result are numbers, divisors are not zero, callees are still the same
+// functions) and bails out when one fails. Since the function had no effects, the interpreter can
+// then simply run the whole call again, and raises any error exactly as it would have.
+//
+// On anything but x86-64 Linux no function is ever compiled.
+class Jit
+{
+   public:
+    // Compiles functions whose bodies are nodes of `ast`
+    Jit(const GlobalEnvironment& globals, const Ast& ast) : globals(globals), ast(ast) {}
+    ~Jit();
+
+    Jit(const Jit&)            = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // Counts a call of `function` and compiles the function once it is hot. Returns false if the
+    // interpreter has to run the call, otherwise sets `result`.
+    bool tryCall(const LoxFunction& function, std::span<const Value> arguments, Value& result);
+
+    // Largest parameter count of a compiled function
+    static constexpr size_t maxParameters = 16;
+
+   private:
+    static constexpr uint32_t callThreshold = 64;
+
+    // Bailouts of a function's code after which calls to it are always interpreted. A bailout
+    // deep in a recursion unwinds every compiled frame above it, and the interpreter, rerunning
+    // them, would otherwise enter compiled code again at each level, making the cost quadratic
+    // in the depth.
+    static constexpr uint32_t bailoutLimit = 8;
+
+    const GlobalEnvironment& globals;
+    const Ast&               ast;
+
+    // Executable mappings holding compiled code, released with the Jit
+    std::vector<std::span<std::byte>> mappings;
+
+    // Functions that compiled code checks a global still holds. Code is shared by every closure of
+    // a definition and may outlive the one it was compiled for, so that one is kept alive to make
+    // sure no other object takes its address.
+    std::vector<Value> guardedFunctions;
+
+    // Result of the last callFromNative that succeeded
+    double callResult = 0;
+
+    // Compiles `function`, updating its state. Returns whether it succeeded.
+    bool compile(const LoxFunction& function);
+
+    // Called by compiled code for a call to the global at `globalIndex`, with `argumentCount`
+    // arguments stored last to first. Only functions that compile are called; returns false to
+    // make the caller bail out otherwise.
+    static bool callFromNative(Jit*          jit,
+                               uint32_t      globalIndex,
+                               uint32_t      argumentCount,
+                               const double* arguments);
+
+    friend class JitCompiler;
+};
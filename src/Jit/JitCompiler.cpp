@@ -0,0 +1,543 @@
+#include "JitCompiler.h"
+
+#include <bit>
+
+#include "../Function/LoxFunction.h"
+#include "Jit.h"
+
+using x64::Condition;
+using x64::Register;
+using x64::Xmm;
+
+std::vector<uint8_t> JitCompiler::compile()
+{
+    const auto& prototype  = function.getPrototype();
+    const auto& parameters = prototype.parameterSlots;
+    if (parameters.size() > Jit::maxParameters || !prototype.captures.empty())
+    {
+        return {};
+    }
+    for (const bool captured : prototype.parameterScope.captured)
+    {
+        if (captured)
+        {
+            return {};
+        }
+    }
+
+    // Frame slots, keeping the stack 16-byte aligned
+    const auto frameBytes = static_cast<int32_t>((prototype.frameSize + 1) / 2 * 16);
+
+    assembler.push(Register::Rbp);
+    assembler.mov(Register::Rbp, Register::Rsp);
+    assembler.push(Register::Rbx);
+    assembler.push(Register::R13);
+    assembler.sub(Register::Rsp, frameBytes);
+    assembler.mov(Register::Rbx, Register::Rsp);
+    assembler.mov(Register::R13, Register::Rsi);
+
+    // Arguments come last to first. With a repeated parameter name the last one wins.
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        const auto offset = static_cast<int32_t>((parameters.size() - 1 - i) * sizeof(double));
+        assembler.loadDouble(Xmm::Xmm0, Register::Rdi, offset);
+        assembler.storeDouble(Register::Rbx, slot(parameters[i]), Xmm::Xmm0);
+    }
+
+    assembler.bind(body);
+    visit(*this, ast, prototype.body);
+
+    // Falling off the end returns nil
+    x64::Label exit;
+    assembler.bind(bailout);
+    assembler.mov32(Register::Rax, 0);
+    assembler.jump(exit);
+
+    assembler.bind(returned);
+    assembler.storeDouble(Register::R13, 0, Xmm::Xmm0);
+    assembler.mov32(Register::Rax, 1);
+
+    assembler.bind(exit);
+    assembler.lea(Register::Rsp, Register::Rbp, -16);
+    assembler.pop(Register::R13);
+    assembler.pop(Register::Rbx);
+    assembler.pop(Register::Rbp);
+    assembler.ret();
+
+    if (!supported)
+    {
+        return {};
+    }
+    return assembler.getCode();
+}
+
+void JitCompiler::push(Xmm reg)
+{
+    assembler.sub(Register::Rsp, sizeof(double));
+    assembler.storeDouble(Register::Rsp, 0, reg);
+    ++temporaries;
+}
+
+void JitCompiler::pop(Xmm reg)
+{
+    assembler.loadDouble(reg, Register::Rsp, 0);
+    assembler.add(Register::Rsp, sizeof(double));
+    --temporaries;
+}
+
+bool JitCompiler::inFrame(const VariableLocation& location)
+{
+    // A local that may be undefined needs its fallback, which lives outside the frame
+    if (location.kind != VariableLocation::Kind::Frame || location.fallback)
+    {
+        unsupported();
+        return false;
+    }
+    return true;
+}
+
+void JitCompiler::branch(StatementId statement)
+{
+    if (statement.kind() == StatementKind::Variable)
+    {
+        unsupported();
+        return;
+    }
+    visit(*this, ast, statement);
+}
+
+void JitCompiler::visitPrintStatement(const PrintStatement&, Environment*)
+{
+    unsupported();
+}
+
+void JitCompiler::visitExpressionStatement(const ExpressionStatement& statement, Environment*)
+{
+    if (statement.toPrint())
+    {
+        unsupported();
+        return;
+    }
+    if (statement.getExpression())
+    {
+        visit(*this, ast, statement.getExpression());
+    }
+}
+
+void JitCompiler::visitVariableStatement(const VariableStatement& statement, Environment*)
+{
+    // Without an initializer the variable would be nil
+    const auto& location = statement.getLocation();
+    if (!statement.getInitializer())
+    {
+        unsupported();
+        return;
+    }
+    if (!inFrame(location))
+    {
+        return;
+    }
+    visit(*this, ast, statement.getInitializer());
+    assembler.storeDouble(Register::Rbx, slot(location.index), Xmm::Xmm0);
+}
+
+void JitCompiler::visitBlockStatement(const BlockStatement& statement, Environment*)
+{
+    for (StatementId stmnt : ast.get(statement.getStatements()))
+    {
+        visit(*this, ast, stmnt);
+    }
+}
+
+void JitCompiler::visitIfStatement(const IfStatement& statement, Environment*)
+{
+    x64::Label otherwise;
+    x64::Label end;
+
+    condition(statement.getCondition(), false, otherwise);
+    branch(statement.getThenBranch());
+    if (statement.getElseBranch())
+    {
+        assembler.jump(end);
+        assembler.bind(otherwise);
+        branch(statement.getElseBranch());
+    }
+    else
+    {
+        assembler.bind(otherwise);
+    }
+    assembler.bind(end);
+}
+
+void JitCompiler::visitWhileStatement(const WhileStatement& statement, Environment*)
+{
+    x64::Label loop;
+    x64::Label end;
+
+    assembler.bind(loop);
+    condition(statement.getCondition(), false, end);
+    branch(statement.getBody());
+    assembler.jump(loop);
+    assembler.bind(end);
+}
+
+void JitCompiler::visitForStatement(const ForStatement& statement, Environment*)
+{
+    x64::Label loop;
+    x64::Label end;
+
+    if (statement.getInitializer())
+    {
+        visit(*this, ast, statement.getInitializer());
+    }
+    assembler.bind(loop);
+    if (statement.getCondition())
+    {
+        condition(statement.getCondition(), false, end);
+    }
+    branch(statement.getBody());
+    if (statement.getIncrement())
+    {
+        visit(*this, ast, statement.getIncrement());
+    }
+    assembler.jump(loop);
+    assembler.bind(end);
+}
+
+void JitCompiler::visitFunctionDefinitionStatement(const FunctionDefinitionStatement&, Environment*)
+{
+    unsupported();
+}
+
+void JitCompiler::visitReturnStatement(const ReturnStatement& statement, Environment*)
+{
+    const ExpressionId value = statement.getExpression();
+    if (!value)
+    {
+        unsupported();
+        return;
+    }
+
+    if (!statement.isTailCall())
+    {
+        visit(*this, ast, value);
+        assembler.jump(returned);
+        return;
+    }
+
+    // Only a tail call of the function itself is compiled, as a jump back to the start of its body
+    // with the arguments in the parameter slots. Anything else would grow the machine stack where
+    // the interpreter does not.
+    const auto&               call    = ast.get<CallExpression>(value);
+    const VariableExpression* callee  = arguments(call);
+    const auto&               globals = jit.globals;
+    if (!callee || !globals.isDefined(callee->getLocation().index) ||
+        globals.get(callee->getLocation().index).asObject() != &function ||
+        call.getArguments().size != static_cast<uint32_t>(function.arity()))
+    {
+        unsupported();
+        return;
+    }
+
+    // Bail out if the global no longer holds this function
+    const Value& global = globals.get(callee->getLocation().index);
+    jit.guardedFunctions.push_back(global);
+    assembler.mov(Register::Rax, reinterpret_cast<uint64_t>(&global));
+    assembler.load(Register::Rax, Register::Rax, 0);
+    assembler.mov(Register::Rcx, global.getBits());
+    assembler.cmp(Register::Rax, Register::Rcx);
+    assembler.jump(Condition::NotEqual, bailout);
+
+    const auto& parameters = function.getPrototype().parameterSlots;
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        const auto offset = static_cast<int32_t>((parameters.size() - 1 - i) * sizeof(double));
+        assembler.loadDouble(Xmm::Xmm0, Register::Rsp, offset);
+        assembler.storeDouble(Register::Rbx, slot(parameters[i]), Xmm::Xmm0);
+    }
+    assembler.add(Register::Rsp, static_cast<int32_t>(parameters.size() * sizeof(double)));
+    temporaries -= parameters.size();
+    assembler.jump(body);
+}
+
+void JitCompiler::visitLiteralExpression(const LiteralExpression& expr, Environment*)
+{
+    if (expr.getType() != LiteralType::Number)
+    {
+        unsupported();
+        return;
+    }
+    assembler.mov(Register::Rax, std::bit_cast<uint64_t>(expr.getConstant().asNumber()));
+    assembler.movq(Xmm::Xmm0, Register::Rax);
+}
+
+void JitCompiler::visitUnaryExpression(const UnaryExpression& expr, Environment*)
+{
+    // `!` makes a bool, so it is only compiled as a condition
+    if (expr.getOperator() != UnaryOperator::Negate)
+    {
+        unsupported();
+        return;
+    }
+    visit(*this, ast, expr.getRight());
+    assembler.mov(Register::Rax, std::bit_cast<uint64_t>(-0.0));
+    assembler.movq(Xmm::Xmm1, Register::Rax);
+    assembler.xorpd(Xmm::Xmm0, Xmm::Xmm1);
+}
+
+void JitCompiler::operands(const BinaryExpression& expr)
+{
+    visit(*this, ast, expr.getLeft());
+    push(Xmm::Xmm0);
+    visit(*this, ast, expr.getRight());
+    assembler.movsd(Xmm::Xmm1, Xmm::Xmm0);
+    pop(Xmm::Xmm0);
+}
+
+void JitCompiler::visitBinaryExpression(const BinaryExpression& expr, Environment*)
+{
+    if (!Operators::isArithmetic(expr.getOperator()))
+    {
+        unsupported();
+        return;
+    }
+    operands(expr);
+
+    switch (expr.getOperator())
+    {
+        case BinaryOperator::Add:
+            assembler.arithmetic(x64::Arithmetic::Add, Xmm::Xmm0, Xmm::Xmm1);
+            break;
+        case BinaryOperator::Subtract:
+            assembler.arithmetic(x64::Arithmetic::Subtract, Xmm::Xmm0, Xmm::Xmm1);
+            break;
+        case BinaryOperator::Multiply:
+            assembler.arithmetic(x64::Arithmetic::Multiply, Xmm::Xmm0, Xmm::Xmm1);
+            break;
+        default:
+        {
+            // Leave division by zero for the interpreter to report. A NaN divisor is fine.
+            x64::Label divide;
+            assembler.xorpd(Xmm::Xmm2, Xmm::Xmm2);
+            assembler.ucomisd(Xmm::Xmm1, Xmm::Xmm2);
+            assembler.jump(Condition::Parity, divide);
+            assembler.jump(Condition::Equal, bailout);
+            assembler.bind(divide);
+            assembler.arithmetic(x64::Arithmetic::Divide, Xmm::Xmm0, Xmm::Xmm1);
+            break;
+        }
+    }
+}
+
+void JitCompiler::visitGroupingExpression(const GroupingExpression& expr, Environment*)
+{
+    visit(*this, ast, expr.getExpression());
+}
+
+void JitCompiler::visitVariableExpression(const VariableExpression& expr, Environment*)
+{
+    const auto& location = expr.getLocation();
+    if (!inFrame(location))
+    {
+        return;
+    }
+    assembler.loadDouble(Xmm::Xmm0, Register::Rbx, slot(location.index));
+}
+
+void JitCompiler::visitAssignmentExpression(const AssignmentExpression& expr, Environment*)
+{
+    const auto& location = expr.getLocation();
+    if (!inFrame(location))
+    {
+        return;
+    }
+    visit(*this, ast, expr.getValue());
+    assembler.storeDouble(Register::Rbx, slot(location.index), Xmm::Xmm0);
+}
+
+void JitCompiler::visitLogicalExpression(const LogicalExpression&, Environment*)
+{
+    // `and` and `or` may produce a non-number operand, so they are only compiled as conditions
+    unsupported();
+}
+
+const VariableExpression* JitCompiler::arguments(const CallExpression& expr)
+{
+    if (expr.getCallee().kind() != ExpressionKind::Variable)
+    {
+        return nullptr;
+    }
+    const auto* callee = &ast.get<VariableExpression>(expr.getCallee());
+    if (callee->getLocation().kind != VariableLocation::Kind::Global)
+    {
+        return nullptr;
+    }
+    for (ExpressionId argument : ast.get(expr.getArguments()))
+    {
+        visit(*this, ast, argument);
+        push(Xmm::Xmm0);
+    }
+    return callee;
+}
+
+void JitCompiler::visitCallExpression(const CallExpression& expr, Environment*)
+{
+    const VariableExpression* callee = arguments(expr);
+    if (!callee)
+    {
+        unsupported();
+        return;
+    }
+
+    // The stack is aligned when no temporaries are pushed, and must be again at the call
+    const auto count   = expr.getArguments().size;
+    const auto padding = static_cast<int32_t>(temporaries % 2 * sizeof(double));
+    if (padding)
+    {
+        assembler.sub(Register::Rsp, padding);
+    }
+
+    assembler.mov(Register::Rdi, reinterpret_cast<uint64_t>(&jit));
+    assembler.mov32(Register::Rsi, callee->getLocation().index);
+    assembler.mov32(Register::Rdx, count);
+    assembler.lea(Register::Rcx, Register::Rsp, padding);
+    assembler.mov(Register::Rax, reinterpret_cast<uint64_t>(&Jit::callFromNative));
+    assembler.call(Register::Rax);
+
+    assembler.add(Register::Rsp, static_cast<int32_t>(padding + count * sizeof(double)));
+    temporaries -= count;
+
+    assembler.testLowByte(Register::Rax);
+    assembler.jump(Condition::Equal, bailout);
+    assembler.mov(Register::Rax, reinterpret_cast<uint64_t>(&jit.callResult));
+    assembler.loadDouble(Xmm::Xmm0, Register::Rax, 0);
+}
+
+void JitCompiler::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                    Environment*)
+{
+    visit(*this, ast, expr.getAssignment());
+}
+
+void JitCompiler::visitComparisonExpression(const ComparisonExpression& expr, Environment*)
+{
+    visit(*this, ast, expr.getComparison());
+}
+
+void JitCompiler::condition(ExpressionId expr, bool jumpIf, x64::Label& target)
+{
+    switch (expr.kind())
+    {
+        case ExpressionKind::Grouping:
+            condition(ast.get<GroupingExpression>(expr).getExpression(), jumpIf, target);
+            return;
+        case ExpressionKind::Comparison:
+            condition(ast.get<ComparisonExpression>(expr).getComparison(), jumpIf, target);
+            return;
+        case ExpressionKind::Unary:
+        {
+            const auto& unary = ast.get<UnaryExpression>(expr);
+            if (unary.getOperator() == UnaryOperator::Not)
+            {
+                condition(unary.getRight(), !jumpIf, target);
+                return;
+            }
+            break;
+        }
+        case ExpressionKind::Logical:
+        {
+            // A truthy left operand decides an `or`, and a falsy one an `and`
+            const auto& logical         = ast.get<LogicalExpression>(expr);
+            const bool  shortCircuitsOn = logical.getOperator() == LogicalOperator::Or;
+            if (jumpIf == shortCircuitsOn)
+            {
+                condition(logical.getLeft(), jumpIf, target);
+                condition(logical.getRight(), jumpIf, target);
+            }
+            else
+            {
+                x64::Label skip;
+                condition(logical.getLeft(), shortCircuitsOn, skip);
+                condition(logical.getRight(), jumpIf, target);
+                assembler.bind(skip);
+            }
+            return;
+        }
+        case ExpressionKind::Binary:
+        {
+            const auto& binary = ast.get<BinaryExpression>(expr);
+            if (!Operators::isArithmetic(binary.getOperator()))
+            {
+                operands(binary);
+                compare(binary.getOperator(), jumpIf, target);
+                return;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // A number is truthy unless it is zero
+    visit(*this, ast, expr);
+    assembler.xorpd(Xmm::Xmm1, Xmm::Xmm1);
+    compare(BinaryOperator::NotEqual, jumpIf, target);
+}
+
+void JitCompiler::compare(BinaryOperator op, bool jumpIf, x64::Label& target)
+{
+    // ucomisd reports an unordered result (a NaN operand) as parity, with equal and below also set.
+    // Every comparison involving NaN is false except `!=`.
+    switch (op)
+    {
+        case BinaryOperator::Equal:
+        case BinaryOperator::NotEqual:
+        {
+            assembler.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+            if (jumpIf == (op == BinaryOperator::NotEqual))
+            {
+                assembler.jump(Condition::Parity, target);
+                assembler.jump(Condition::NotEqual, target);
+            }
+            else
+            {
+                x64::Label unordered;
+                assembler.jump(Condition::Parity, unordered);
+                assembler.jump(Condition::Equal, target);
+                assembler.bind(unordered);
+            }
+            break;
+        }
+        case BinaryOperator::Greater:
+        case BinaryOperator::GreaterEqual:
+        case BinaryOperator::Less:
+        case BinaryOperator::LessEqual:
+        {
+            // Compare so that the relation holds when above, which is false when unordered
+            const bool greater =
+                op == BinaryOperator::Greater || op == BinaryOperator::GreaterEqual;
+            const bool strict = op == BinaryOperator::Greater || op == BinaryOperator::Less;
+            if (greater)
+            {
+                assembler.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+            }
+            else
+            {
+                assembler.ucomisd(Xmm::Xmm1, Xmm::Xmm0);
+            }
+
+            if (jumpIf)
+            {
+                assembler.jump(strict ? Condition::Above : Condition::AboveEqual, target);
+            }
+            else
+            {
+                assembler.jump(strict ? Condition::BelowEqual : Condition::Below, target);
+            }
+            break;
+        }
+        default:
+            unsupported();
+            break;
+    }
+}
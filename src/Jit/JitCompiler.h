@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../Ast/Ast.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+#include "Assembler.h"
+
+class Jit;
+class LoxFunction;
+
+// Translates the body of one function to x86-64, node by node, for the Jit.
+//
+// Every number lives in a frame slot on the machine stack, laid out as the Resolver assigned
+// them, and expressions compute into xmm0 with intermediate results pushed on the machine stack.
+// Comparisons are only compiled as conditions, where they turn into branches; a node that could
+// make a value other than a number, or have an effect, makes the whole function unsupported.
+//
+// Registers: rbx holds the frame, r13 the result pointer, rbp the machine frame.
+class JitCompiler : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    JitCompiler(Jit& jit, const Ast& ast, const LoxFunction& function)
+        : jit(jit), ast(ast), function(function)
+    {
+    }
+
+    // Machine code of the function, or nothing if it uses anything the Jit does not support
+    std::vector<uint8_t> compile();
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    Jit&               jit;
+    const Ast&         ast;
+    const LoxFunction& function;
+
+    x64::Assembler assembler;
+
+    x64::Label body;      // Start of the body, where a tail call to the function itself jumps
+    x64::Label returned;  // Returns the number in xmm0
+    x64::Label bailout;   // Returns false
+
+    bool supported = true;
+
+    // Intermediate results currently pushed on the machine stack
+    uint32_t temporaries = 0;
+
+    void unsupported() { supported = false; }
+
+    void push(x64::Xmm reg);
+    void pop(x64::Xmm reg);
+
+    // Whether compiled code can use the variable at `location` in its frame slot; if not, the
+    // function is marked unsupported
+    bool inFrame(const VariableLocation& location);
+
+    // Offset of frame slot `index` from rbx
+    static int32_t slot(uint32_t index) { return static_cast<int32_t>(index * sizeof(double)); }
+
+    // Evaluates the operands of `expr` into xmm0 and xmm1
+    void operands(const BinaryExpression& expr);
+
+    // Pushes the arguments of `expr`, checking it calls a global with a matching argument count
+    const VariableExpression* arguments(const CallExpression& expr);
+
+    // Jumps to `target` if `expr` is truthy and `jumpIf` is set, or falsy and it is not
+    void condition(ExpressionId expr, bool jumpIf, x64::Label& target);
+
+    // Jumps to `target` if comparing xmm0 with xmm1 by `op` gives `jumpIf`
+    void compare(BinaryOperator op, bool jumpIf, x64::Label& target);
+
+    // A branch or loop body. A declaration there would leave its slot unset when skipped.
+    void branch(StatementId statement);
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+// Entry point of a function compiled by the Jit. Arguments are passed last to first, which is the
+// order calls in compiled code push them. Returns false if the code bailed out, in which case
+// `result` is unset and the call has to be run by the interpreter.
+using NativeCode = bool (*)(const double* arguments, double* result);
+
+// Tier-up state of one function definition, kept by its FunctionPrototype and managed by the Jit
+struct JitState
+{
+    enum class Status : uint8_t
+    {
+        Interpreted,  // Not hot yet
+        Compiled,
+        Rejected  // Uses something the Jit does not compile, or bails out too often
+    };
+
+    Status     status       = Status::Interpreted;
+    uint32_t   callCount    = 0;
+    uint32_t   bailoutCount = 0;
+    NativeCode code         = nullptr;
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// The operators, their lexemes, what they do to numbers and the errors they raise. Nothing here
+// depends on the interpreter's Value, so the runtime of translated programs, see
+// Transpiler/Runtime.h, is built from this same file.
+
+// Operators are resolved from their lexemes once, by the parser, so evaluation can dispatch on a
+// dense enum instead of hashing or comparing strings.
+enum class BinaryOperator : uint8_t
+{
+    // Arithmetic
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+
+    // Equality
+    Equal,
+    NotEqual,
+
+    // Relational
+    Greater,
+    GreaterEqual,
+    Less,
+    LessEqual
+};
+
+enum class UnaryOperator : uint8_t
+{
+    Negate,
+    Not
+};
+
+enum class LogicalOperator : uint8_t
+{
+    And,
+    Or
+};
+
+namespace Operators
+{
+
+// Indexed by the enum value, so the order must match the enum declarations
+constexpr std::array<const char*, 10> binaryLexemes = {
+    "+", "-", "*", "/", "==", "!=", ">", ">=", "<", "<="};
+constexpr std::array<const char*, 2> unaryLexemes   = {"-", "!"};
+constexpr std::array<const char*, 2> logicalLexemes = {"and", "or"};
+
+constexpr const char* toLexeme(BinaryOperator op)
+{
+    return binaryLexemes[static_cast<size_t>(op)];
+}
+
+constexpr const char* toLexeme(UnaryOperator op)
+{
+    return unaryLexemes[static_cast<size_t>(op)];
+}
+
+constexpr const char* toLexeme(LogicalOperator op)
+{
+    return logicalLexemes[static_cast<size_t>(op)];
+}
+
+// Handle arithmetic operators
+inline double add(double lhs, double rhs)
+{
+    return lhs + rhs;
+}
+
+inline double subtract(double lhs, double rhs)
+{
+    return lhs - rhs;
+}
+
+inline double multiply(double lhs, double rhs)
+{
+    return lhs * rhs;
+}
+
+inline double divide(double lhs, double rhs)
+{
+    if (rhs == 0.0) throw std::runtime_error("Division by zero");
+    return lhs / rhs;
+}
+
+// Evaluate arithmetic and relational operators on two numbers. Equality is handled by the caller
+// since it applies to every type.
+inline double arithmetic(BinaryOperator op, double lhs, double rhs)
+{
+    switch (op)
+    {
+        case BinaryOperator::Add:
+            return add(lhs, rhs);
+        case BinaryOperator::Subtract:
+            return subtract(lhs, rhs);
+        case BinaryOperator::Multiply:
+            return multiply(lhs, rhs);
+        default:
+            return divide(lhs, rhs);
+    }
+}
+
+inline bool relational(BinaryOperator op, double lhs, double rhs)
+{
+    switch (op)
+    {
+        case BinaryOperator::Greater:
+            return lhs > rhs;
+        case BinaryOperator::GreaterEqual:
+            return lhs >= rhs;
+        case BinaryOperator::Less:
+            return lhs < rhs;
+        default:
+            return lhs <= rhs;
+    }
+}
+
+constexpr bool isArithmetic(BinaryOperator op)
+{
+    return op <= BinaryOperator::Divide;
+}
+
+constexpr bool isEquality(BinaryOperator op)
+{
+    return op == BinaryOperator::Equal || op == BinaryOperator::NotEqual;
+}
+
+constexpr bool isRelational(BinaryOperator op)
+{
+    return op >= BinaryOperator::Greater;
+}
+
+// Result of `Op` on two numbers: a number for arithmetic, a bool for the rest
+template <BinaryOperator Op>
+auto numbers(double lhs, double rhs)
+{
+    if constexpr (isArithmetic(Op))
+    {
+        return arithmetic(Op, lhs, rhs);
+    }
+    else if constexpr (Op == BinaryOperator::Equal)
+    {
+        return lhs == rhs;
+    }
+    else if constexpr (Op == BinaryOperator::NotEqual)
+    {
+        return lhs != rhs;
+    }
+    else
+    {
+        return relational(Op, lhs, rhs);
+    }
+}
+
+// Messages of the errors raised for operands an operator does not support
+inline std::string unsupportedOperands(BinaryOperator op, const char* operandKind)
+{
+    return "Unsupported operator " + std::string(toLexeme(op)) + " for " + operandKind;
+}
+
+inline std::string incompatibleOperands(BinaryOperator op)
+{
+    return "Incompatible types for operator " + std::string(toLexeme(op));
+}
+
+constexpr const char* negateOperandError = "Operand of '-' must be a number.";
+constexpr const char* notOperandError    = "Operand of '!' must be a boolean or nil.";
+
+}  // namespace Operators
@@ -0,0 +1,189 @@
+#include "Operators.h"
+
+#include <array>
+#include <utility>
+
+#include "../Evaluator/EvaluatorError.h"
+
+namespace
+{
+
+constexpr size_t operatorCount = static_cast<size_t>(BinaryOperator::LessEqual) + 1;
+constexpr size_t typeCount     = static_cast<size_t>(ValueType::Count);
+
+template <typename Op, size_t N>
+std::optional<Op> fromLexeme(const std::array<const char*, N>& lexemes, const std::string& lexeme)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (lexeme == lexemes[i])
+        {
+            return static_cast<Op>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+[[noreturn]] void unsupported(BinaryOperator op, const char* operandKind)
+{
+    throw EvaluatorError(Operators::unsupportedOperands(op, operandKind));
+}
+
+// Each family provides one handler per operator for a pair of operand types
+struct NumberOperations
+{
+    template <BinaryOperator Op>
+    static Value apply(const Value& lhs, const Value& rhs)
+    {
+        return Value(Operators::numbers<Op>(lhs.asNumber(), rhs.asNumber()));
+    }
+};
+
+struct StringOperations
+{
+    template <BinaryOperator Op>
+    static Value apply(const Value& lhs, const Value& rhs)
+    {
+        if constexpr (Op == BinaryOperator::Add)
+        {
+            return Value(lhs.asString() + rhs.asString());
+        }
+        else if constexpr (Op == BinaryOperator::Equal)
+        {
+            return Value(lhs.asString() == rhs.asString());
+        }
+        else if constexpr (Op == BinaryOperator::NotEqual)
+        {
+            return Value(lhs.asString() != rhs.asString());
+        }
+        else
+        {
+            unsupported(Op, "strings");
+        }
+    }
+};
+
+struct BoolOperations
+{
+    template <BinaryOperator Op>
+    static Value apply(const Value& lhs, const Value& rhs)
+    {
+        if constexpr (Op == BinaryOperator::Equal)
+        {
+            return Value(lhs.asBool() == rhs.asBool());
+        }
+        else if constexpr (Op == BinaryOperator::NotEqual)
+        {
+            return Value(lhs.asBool() != rhs.asBool());
+        }
+        else
+        {
+            unsupported(Op, "booleans");
+        }
+    }
+};
+
+// Any other pairing, including nil with nil and callables, only supports (in)equality, and is
+// never equal
+struct IncompatibleOperations
+{
+    template <BinaryOperator Op>
+    static Value apply(const Value&, const Value&)
+    {
+        if constexpr (Operators::isEquality(Op))
+        {
+            return Value(Op == BinaryOperator::NotEqual);
+        }
+        else
+        {
+            throw EvaluatorError(Operators::incompatibleOperands(Op));
+        }
+    }
+};
+
+using BinaryHandler = Value (*)(const Value&, const Value&);
+using HandlerRow = std::array<BinaryHandler, operatorCount>;
+
+template <typename Operations, size_t... Ops>
+constexpr HandlerRow makeRow(std::index_sequence<Ops...>)
+{
+    return {&Operations::template apply<static_cast<BinaryOperator>(Ops)>...};
+}
+
+template <typename Operations>
+constexpr HandlerRow makeRow()
+{
+    return makeRow<Operations>(std::make_index_sequence<operatorCount>());
+}
+
+constexpr auto makeBinaryTable()
+{
+    std::array<std::array<HandlerRow, typeCount>, typeCount> table{};
+    for (size_t left = 0; left < typeCount; ++left)
+    {
+        for (size_t right = 0; right < typeCount; ++right)
+        {
+            table[left][right] = makeRow<IncompatibleOperations>();
+        }
+    }
+
+    auto index = [](ValueType type) { return static_cast<size_t>(type); };
+    table[index(ValueType::Number)][index(ValueType::Number)] = makeRow<NumberOperations>();
+    table[index(ValueType::String)][index(ValueType::String)] = makeRow<StringOperations>();
+    table[index(ValueType::Bool)][index(ValueType::Bool)]     = makeRow<BoolOperations>();
+    return table;
+}
+
+constexpr auto binaryTable = makeBinaryTable();
+
+}  // namespace
+
+namespace Operators
+{
+
+Value dispatchBinary(BinaryOperator op, const Value& lhs, const Value& rhs)
+{
+    const auto& row = binaryTable[static_cast<size_t>(lhs.type())][static_cast<size_t>(rhs.type())];
+    return row[static_cast<size_t>(op)](lhs, rhs);
+}
+
+Value unary(UnaryOperator op, const Value& operand)
+{
+    if (op == UnaryOperator::Negate)
+    {
+        if (!operand.isNumber())
+        {
+            throw EvaluatorError(Operators::negateOperandError);
+        }
+        return Value(-operand.asNumber());
+    }
+
+    switch (operand.type())
+    {
+        case ValueType::Bool:
+            return Value(!operand.asBool());
+        case ValueType::Number:
+            return Value(!operand.asNumber());
+        case ValueType::Nil:
+            return Value(true);
+        default:
+            throw EvaluatorError(Operators::notOperandError);
+    }
+}
+
+std::optional<BinaryOperator> toBinaryOperator(const std::string& lexeme)
+{
+    return fromLexeme<BinaryOperator>(Operators::binaryLexemes, lexeme);
+}
+
+std::optional<UnaryOperator> toUnaryOperator(const std::string& lexeme)
+{
+    return fromLexeme<UnaryOperator>(Operators::unaryLexemes, lexeme);
+}
+
+std::optional<LogicalOperator> toLogicalOperator(const std::string& lexeme)
+{
+    return fromLexeme<LogicalOperator>(Operators::logicalLexemes, lexeme);
+}
+
+}  // namespace Operators
@@ -1,36 +1,60 @@
 #pragma once
 
-#include <functional>
+#include <cstdint>
+#include <optional>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
+
+#include "../Value/Value.h"
+#include "OperatorDefinitions.h"
 
 namespace Operators
 {
 
-// Handle arithmetic operators
-inline const std::unordered_map<std::string, std::function<double(double, double)>> arithmeticOps =
-    {{"+", [](double lhs, double rhs) { return lhs + rhs; }},
-     {"-", [](double lhs, double rhs) { return lhs - rhs; }},
-     {"*", [](double lhs, double rhs) { return lhs * rhs; }},
-     {"/", [](double lhs, double rhs) {
-          if (rhs == 0.0) throw std::runtime_error("Division by zero");
-          return lhs / rhs;
-      }}};
-
-// Handle equality operators (templated)
-template <typename T>
-inline const std::unordered_map<std::string, std::function<bool(const T&, const T&)>> equalityOps =
+// Any binary operation that is not number-by-number. Dispatches through a table indexed by
+// (left type, right type, operator), so no runtime type information is needed.
+Value dispatchBinary(BinaryOperator op, const Value& lhs, const Value& rhs);
+
+// Evaluate a binary operator on two runtime values
+inline Value binary(BinaryOperator op, const Value& lhs, const Value& rhs)
+{
+    if (Value::areNumbers(lhs, rhs))
     {
-        {"==", [](const T& lhs, const T& rhs) { return lhs == rhs; }},
-        {"!=", [](const T& lhs, const T& rhs) { return lhs != rhs; }},
-};
-
-// Handle relational operators
-inline const std::unordered_map<std::string, std::function<bool(double, double)>> relationalOps = {
-    {">", [](double lhs, double rhs) { return lhs > rhs; }},
-    {"<", [](double lhs, double rhs) { return lhs < rhs; }},
-    {">=", [](double lhs, double rhs) { return lhs >= rhs; }},
-    {"<=", [](double lhs, double rhs) { return lhs <= rhs; }},
-};
+        const double left  = lhs.asNumber();
+        const double right = rhs.asNumber();
+        switch (op)
+        {
+            case BinaryOperator::Add:
+                return Value(add(left, right));
+            case BinaryOperator::Subtract:
+                return Value(subtract(left, right));
+            case BinaryOperator::Multiply:
+                return Value(multiply(left, right));
+            case BinaryOperator::Divide:
+                return Value(divide(left, right));
+            case BinaryOperator::Equal:
+                return Value(left == right);
+            case BinaryOperator::NotEqual:
+                return Value(left != right);
+            case BinaryOperator::Greater:
+                return Value(left > right);
+            case BinaryOperator::GreaterEqual:
+                return Value(left >= right);
+            case BinaryOperator::Less:
+                return Value(left < right);
+            case BinaryOperator::LessEqual:
+                return Value(left <= right);
+        }
+    }
+    return dispatchBinary(op, lhs, rhs);
+}
+
+// Evaluate a unary operator on a runtime value
+Value unary(UnaryOperator op, const Value& operand);
+
+// Lexeme conversions, used by the parser
+std::optional<BinaryOperator>  toBinaryOperator(const std::string& lexeme);
+std::optional<UnaryOperator>   toUnaryOperator(const std::string& lexeme);
+std::optional<LogicalOperator> toLogicalOperator(const std::string& lexeme);
 
 }  // namespace Operators
@@ -0,0 +1,1094 @@
+#include "Optimizer.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "../Operators/Operators.h"
+#include "../Utils/StringUtils.h"
+
+namespace
+{
+
+// Event of a trace for an operation that may fail or have an effect
+constexpr int effect = -1;
+
+// Index of the parameter in `parameters` called `name`, or `effect` if there is none. When a name
+// is repeated the last one wins, as each argument is assigned in turn.
+int parameterIndex(const Ast& ast, IdList<NameId> parameters, NameId name)
+{
+    const auto names = ast.get(parameters);
+    auto       it    = std::find(names.rbegin(), names.rend(), name);
+    return it != names.rend() ? static_cast<int>(names.rend() - it) - 1 : effect;
+}
+
+// The expression a fused node stands for, or `expr` itself
+ExpressionId unfused(const Ast& ast, ExpressionId expr)
+{
+    switch (expr.kind())
+    {
+        case ExpressionKind::CompoundAssignment:
+            return ast.get<CompoundAssignmentExpression>(expr).getAssignment();
+        case ExpressionKind::Comparison:
+            return ast.get<ComparisonExpression>(expr).getComparison();
+        default:
+            return expr;
+    }
+}
+
+// Appends to `events` what evaluating `expr`, part of the body of `function`, does in order: the
+// index of each parameter it reads, and `effect` for anything else observable. Counts the nodes in
+// `size` and notes whether there are calls. Returns false if the expression cannot be inlined at
+// all: it refers to the function itself or assigns a parameter.
+bool trace(const Ast&                         ast,
+           ExpressionId                       node,
+           const FunctionDefinitionStatement& function,
+           std::vector<int>&                  events,
+           size_t&                            size,
+           bool&                              calls)
+{
+    const ExpressionId expr = unfused(ast, node);
+    ++size;
+
+    switch (expr.kind())
+    {
+        case ExpressionKind::Literal:
+            return true;
+        case ExpressionKind::Grouping:
+        {
+            const auto& grouping = ast.get<GroupingExpression>(expr);
+            return trace(ast, grouping.getExpression(), function, events, size, calls);
+        }
+        case ExpressionKind::Variable:
+        {
+            // Any other name is a global, which may be undefined
+            const NameId name = ast.get<VariableExpression>(expr).getName();
+            events.push_back(parameterIndex(ast, function.getParameters(), name));
+            return name != function.getName();
+        }
+        case ExpressionKind::Unary:
+        {
+            const auto& unary = ast.get<UnaryExpression>(expr);
+            const bool  valid = trace(ast, unary.getRight(), function, events, size, calls);
+            events.push_back(effect);
+            return valid;
+        }
+        case ExpressionKind::Binary:
+        {
+            const auto& binary = ast.get<BinaryExpression>(expr);
+            const bool  valid  = trace(ast, binary.getLeft(), function, events, size, calls) &&
+                               trace(ast, binary.getRight(), function, events, size, calls);
+            if (!Operators::isEquality(binary.getOperator()))
+            {
+                events.push_back(effect);
+            }
+            return valid;
+        }
+        case ExpressionKind::Logical:
+        {
+            // Whether the right operand is evaluated at all depends on the left one
+            const auto& logical = ast.get<LogicalExpression>(expr);
+            const bool  valid   = trace(ast, logical.getLeft(), function, events, size, calls);
+            events.push_back(effect);
+            return valid && trace(ast, logical.getRight(), function, events, size, calls);
+        }
+        case ExpressionKind::Assignment:
+        {
+            const auto& assignment = ast.get<AssignmentExpression>(expr);
+            const bool  valid = trace(ast, assignment.getValue(), function, events, size, calls);
+            events.push_back(effect);
+            return valid &&
+                   parameterIndex(ast, function.getParameters(), assignment.getName()) == effect &&
+                   assignment.getName() != function.getName();
+        }
+        default:
+            break;
+    }
+
+    const auto& call  = ast.get<CallExpression>(expr);
+    bool        valid = trace(ast, call.getCallee(), function, events, size, calls);
+    for (ExpressionId argument : ast.get(call.getArguments()))
+    {
+        valid = valid && trace(ast, argument, function, events, size, calls);
+    }
+    events.push_back(effect);
+    calls = true;
+    return valid;
+}
+
+// Reads the nodes of an Ast by copy, for visiting nodes of the Ast being added to, which may move
+// the node a reference points to
+struct Snapshot
+{
+    const Ast& ast;
+
+    template <typename Node>
+    Node get(typename Node::Id id) const
+    {
+        return ast.get<Node>(id);
+    }
+};
+
+}  // namespace
+
+Ast Optimizer::optimize(const Ast& program)
+{
+    std::vector<StatementId> optimized;
+    for (Pass current : {Pass::FindAssignments, Pass::Rewrite})
+    {
+        pass   = current;
+        output = Ast::withStringsOf(program);
+        source = &program;
+        nil    = output.add(
+            LiteralExpression(output.intern("nil"), LiteralType::Nil, constants.addNil()));
+        globals.clear();
+        references.clear();
+        inlinable.clear();
+        defined.clear();
+        optimized = rewrite(program.getStatements());
+    }
+
+    // Tree shaking: a top-level function that only unused functions refer to is never called.
+    // Functions whose name is declared more than once are kept, as a reference may be to either.
+    std::unordered_set<NameId> used;
+    std::vector<NameId>        pending(references[script].begin(), references[script].end());
+    while (!pending.empty())
+    {
+        const NameId name = pending.back();
+        pending.pop_back();
+        if (used.insert(name).second)
+        {
+            const auto& referenced = references[name];
+            pending.insert(pending.end(), referenced.begin(), referenced.end());
+        }
+    }
+    std::erase_if(optimized,
+                  [&](StatementId stmnt)
+                  {
+                      if (stmnt.kind() != StatementKind::FunctionDefinition)
+                      {
+                          return false;
+                      }
+                      const NameId name = output.get<FunctionDefinitionStatement>(stmnt).getName();
+                      return !used.count(name) && !reassigned.count(name);
+                  });
+    output.setStatements(optimized);
+    return std::move(output);
+}
+
+std::vector<StatementId> Optimizer::rewrite(std::span<const StatementId> statements)
+{
+    std::vector<StatementId> rewritten;
+    for (StatementId stmnt : statements)
+    {
+        StatementId optimized = rewrite(stmnt);
+        observed();
+        rewritten.insert(rewritten.end(), preceding.begin(), preceding.end());
+        preceding.clear();
+
+        if (!optimized || (optimized.kind() == StatementKind::Block &&
+                           output.get<BlockStatement>(optimized).getStatements().size == 0))
+        {
+            continue;
+        }
+
+        // Nothing after a `return` runs
+        rewritten.push_back(optimized);
+        if (optimized.kind() == StatementKind::Return)
+        {
+            break;
+        }
+    }
+    return rewritten;
+}
+
+template <typename Id>
+void Optimizer::dispatch(Id id)
+{
+    if (source == &output)
+    {
+        visit(*this, Snapshot{output}, id);
+    }
+    else
+    {
+        visit(*this, *source, id);
+    }
+}
+
+ExpressionId Optimizer::rewrite(ExpressionId expr)
+{
+    if (!expr)
+    {
+        return {};
+    }
+    if (!hoist(expr))
+    {
+        dispatch(expr);
+    }
+    return expression;
+}
+
+StatementId Optimizer::rewrite(StatementId stmnt)
+{
+    if (!stmnt)
+    {
+        return {};
+    }
+    dispatch(stmnt);
+    return statement;
+}
+
+ExpressionId Optimizer::rewriteOutput(ExpressionId expr)
+{
+    const Ast* enclosing = source;
+    source               = &output;
+    auto rewritten       = rewrite(expr);
+    source               = enclosing;
+    return rewritten;
+}
+
+StatementId Optimizer::rewriteBranch(StatementId stmnt)
+{
+    const bool enclosing = conditional;
+    conditional          = true;
+    auto branch          = rewrite(stmnt);
+    conditional          = enclosing;
+
+    // A branch that was removed entirely still needs a statement
+    if (stmnt && !branch)
+    {
+        branch = output.add(BlockStatement({}));
+    }
+    return branch;
+}
+
+bool Optimizer::isRemovable(StatementId stmnt)
+{
+    // A declaration reserves its name in the enclosing scope even if it never runs
+    return !stmnt || stmnt.kind() != StatementKind::Variable;
+}
+
+std::optional<bool> Optimizer::truthiness(ExpressionId condition) const
+{
+    if (condition && condition.kind() == ExpressionKind::Literal)
+    {
+        return output.get<LiteralExpression>(condition).getConstant().isTruthy();
+    }
+    return std::nullopt;
+}
+
+void Optimizer::declare(NameId name, Constant constant)
+{
+    auto& scope = scopes.empty() ? globals : scopes.back();
+    if (pass == Pass::FindAssignments)
+    {
+        // A second declaration in the same scope reuses the variable, like an assignment
+        if (!scope.emplace(name, Constant()).second)
+        {
+            reassigned.insert(name);
+        }
+        return;
+    }
+    scope[name] = reassigned.count(name) ? Constant() : constant;
+    if (scopes.empty() && !conditional)
+    {
+        defined.insert(name);
+    }
+}
+
+Optimizer::Constant Optimizer::lookup(NameId name)
+{
+    // Scopes are searched like the Resolver does, so the same declaration is found. A local
+    // declared later in an enclosing function is searched past, as the name still refers to what
+    // it did before until the declaration runs
+    bool ahead = false;
+    for (size_t index = scopes.size(); index-- > 0;)
+    {
+        auto       it       = scopes[index].find(name);
+        const bool declared = it != scopes[index].end();
+        if (declared || (index < functionScope && declaredAhead[index].count(name)))
+        {
+            if (index < functionScope)
+            {
+                captured.insert(name);
+            }
+            // The global an inlined body refers to is hidden at the call site
+            if (inlining)
+            {
+                inlining->shadowed = true;
+            }
+            if (!declared)
+            {
+                ahead = true;
+                continue;
+            }
+            return ahead ? Constant() : it->second;
+        }
+    }
+
+    // An undefined global fails when read
+    if (!defined.count(name))
+    {
+        observed();
+    }
+    references[function].insert(name);
+    auto it = globals.find(name);
+    return it != globals.end() && !ahead ? it->second : Constant();
+}
+
+ExpressionId Optimizer::literal(const Value& value)
+{
+    if (value.isNumber())
+    {
+        // Printed the way the scanner prints number literals
+        char       text[400];
+        const auto end = std::to_chars(text, text + sizeof(text), value.asNumber(),
+                                       std::chars_format::fixed)
+                             .ptr;
+        const NameId number = output.intern(formatNumberLiteral(std::string(text, end)));
+        return output.add(
+            LiteralExpression(number, LiteralType::Number, constants.addNumber(value.asNumber())));
+    }
+    if (value.isBool())
+    {
+        return output.add(LiteralExpression(output.intern(value.asBool() ? "true" : "false"),
+                                            LiteralType::Boolean,
+                                            constants.addBoolean(value.asBool())));
+    }
+    const NameId string = output.intern(value.asString());
+    return output.add(
+        LiteralExpression(string, LiteralType::String, constants.addString(value.asString())));
+}
+
+void Optimizer::visitPrintStatement(const PrintStatement& stmnt, Environment* env)
+{
+    statement = output.add(PrintStatement(rewrite(stmnt.getExpression())));
+}
+
+void Optimizer::visitExpressionStatement(const ExpressionStatement& stmnt, Environment* env)
+{
+    statement = output.add(ExpressionStatement(rewrite(stmnt.getExpression()), stmnt.toPrint()));
+}
+
+void Optimizer::visitVariableStatement(const VariableStatement& stmnt, Environment* env)
+{
+    // The initializer is rewritten first, so `var a = a;` reads the enclosing `a`
+    auto initializer = rewrite(stmnt.getInitializer());
+
+    Constant constant = nil;
+    if (conditional)
+    {
+        constant = Constant();
+    }
+    else if (initializer)
+    {
+        constant = initializer.kind() == ExpressionKind::Literal ? initializer : Constant();
+    }
+    declare(stmnt.getName(), constant);
+
+    statement = output.add(VariableStatement(stmnt.getName(), initializer));
+}
+
+void Optimizer::visitBlockStatement(const BlockStatement& stmnt, Environment* env)
+{
+    const bool enclosing = conditional;
+    conditional          = false;
+    scopes.emplace_back();
+    declaredAhead.emplace_back();
+    for (StatementId inner : source->get(stmnt.getStatements()))
+    {
+        forEachDeclaredName(
+            *source, inner, [&](NameId name) { declaredAhead.back().insert(name); });
+    }
+
+    auto statements = rewrite(source->get(stmnt.getStatements()));
+
+    declaredAhead.pop_back();
+    scopes.pop_back();
+    conditional = enclosing;
+
+    statement = output.add(BlockStatement(output.add(statements)));
+}
+
+void Optimizer::visitIfStatement(const IfStatement& stmnt, Environment* env)
+{
+    auto condition = rewrite(stmnt.getCondition());
+
+    // Only the branch that is taken is kept, and it always runs
+    const auto taken = truthiness(condition);
+    if (taken)
+    {
+        const StatementId live = *taken ? stmnt.getThenBranch() : stmnt.getElseBranch();
+        const StatementId dead = *taken ? stmnt.getElseBranch() : stmnt.getThenBranch();
+        if (isRemovable(dead))
+        {
+            statement = rewrite(live);
+            return;
+        }
+    }
+
+    // Which branch runs depends on the condition
+    observed();
+    auto thenBranch = rewriteBranch(stmnt.getThenBranch());
+    auto elseBranch = rewriteBranch(stmnt.getElseBranch());
+
+    statement = output.add(IfStatement(condition, thenBranch, elseBranch));
+}
+
+void Optimizer::visitWhileStatement(const WhileStatement& stmnt, Environment* env)
+{
+    rewriteLoop({}, stmnt.getCondition(), {}, stmnt.getBody(), false);
+}
+
+void Optimizer::visitForStatement(const ForStatement& stmnt, Environment* env)
+{
+    rewriteLoop(stmnt.getInitializer(),
+                stmnt.getCondition(),
+                stmnt.getIncrement(),
+                stmnt.getBody(),
+                true);
+}
+
+void Optimizer::rewriteLoop(StatementId  initializer,
+                            ExpressionId condition,
+                            ExpressionId increment,
+                            StatementId  body,
+                            bool         isFor)
+{
+    // The initializer runs in the enclosing scope, as in the Resolver
+    auto rewrittenInitializer = rewrite(initializer);
+
+    // Invariants are hoisted into a block around the loop, so only a loop that is a statement of a
+    // sequence can get one: as the body of an `if` its initializer may declare a variable there
+    std::vector<StatementId> conditionTemporaries;
+    std::vector<StatementId> bodyTemporaries;
+
+    Hoisting  loop{{}, &conditionTemporaries};
+    Hoisting* enclosing = hoisting;
+    hoisting            = nullptr;
+    if (pass == Pass::Rewrite && !conditional)
+    {
+        summarize(condition, loop.loop);
+        summarize(body, loop.loop);
+        summarize(increment, loop.loop);
+        hoisting = &loop;
+    }
+
+    auto rewrittenCondition = rewrite(condition);
+
+    // A loop that never runs its body leaves only the initializer
+    if (truthiness(rewrittenCondition) == false && isRemovable(body))
+    {
+        hoisting  = enclosing;
+        statement = rewrittenInitializer;
+        return;
+    }
+
+    // The body is only entered once the condition holds. If the condition has no effect it can be
+    // tested once more by a guard, which makes hoisting from the start of the body safe.
+    Summary test;
+    summarize(condition, test);
+    const bool guardable = !test.calls && test.writes.empty();
+    loop.temporaries     = &bodyTemporaries;
+    loop.failurePossible = !condition || guardable;
+    loop.hoistedFallible = false;
+    auto rewrittenBody   = rewriteBranch(body);
+
+    // The increment runs after the body
+    loop.failurePossible    = false;
+    auto rewrittenIncrement = rewrite(increment);
+
+    // The guard is a copy of the rewritten condition
+    hoisting = nullptr;
+    ExpressionId guard;
+    if (condition && loop.hoistedFallible)
+    {
+        guard = rewriteOutput(rewrittenCondition);
+    }
+    hoisting = enclosing;
+
+    if (conditionTemporaries.empty() && bodyTemporaries.empty())
+    {
+        if (isFor)
+        {
+            statement = output.add(ForStatement(
+                rewrittenInitializer, rewrittenCondition, rewrittenIncrement, rewrittenBody));
+        }
+        else
+        {
+            statement = output.add(WhileStatement(rewrittenCondition, rewrittenBody));
+        }
+        return;
+    }
+
+    // { condition temporaries; if (guard) { body temporaries; loop } }
+    StatementId rewrittenLoop;
+    if (isFor)
+    {
+        rewrittenLoop =
+            output.add(ForStatement({}, rewrittenCondition, rewrittenIncrement, rewrittenBody));
+    }
+    else
+    {
+        rewrittenLoop = output.add(WhileStatement(rewrittenCondition, rewrittenBody));
+    }
+    bodyTemporaries.push_back(rewrittenLoop);
+
+    std::vector<StatementId> statements = std::move(conditionTemporaries);
+    if (guard)
+    {
+        const StatementId guarded = output.add(BlockStatement(output.add(bodyTemporaries)));
+        statements.push_back(output.add(IfStatement(guard, guarded, {})));
+    }
+    else
+    {
+        statements.insert(statements.end(), bodyTemporaries.begin(), bodyTemporaries.end());
+    }
+
+    if (rewrittenInitializer)
+    {
+        preceding.push_back(rewrittenInitializer);
+    }
+    statement = output.add(BlockStatement(output.add(statements)));
+}
+
+bool Optimizer::hoist(ExpressionId expr)
+{
+    const ExpressionKind kind = expr.kind();
+    if (!hoisting || (kind != ExpressionKind::Unary && kind != ExpressionKind::Binary &&
+                      kind != ExpressionKind::Logical))
+    {
+        return false;
+    }
+
+    Summary summary;
+    summarize(expr, summary);
+    if (summary.calls || !summary.writes.empty())
+    {
+        return false;
+    }
+    for (NameId name : summary.reads)
+    {
+        // A call in the loop may assign any global, or a local through a closure
+        if (hoisting->loop.writes.count(name) ||
+            (hoisting->loop.calls && (!isLocal(name) || captured.count(name))))
+        {
+            return false;
+        }
+    }
+
+    const bool silent = isSilent(expr);
+    if (!silent && !hoisting->failurePossible)
+    {
+        return false;
+    }
+
+    Hoisting* loop = hoisting;
+    hoisting       = nullptr;
+    auto value     = rewrite(expr);
+    hoisting       = loop;
+    if (value.kind() == ExpressionKind::Literal)
+    {
+        expression = value;
+        return true;
+    }
+
+    // Not a valid identifier, so it cannot clash with a name in the program
+    const NameId name = output.intern("$" + std::to_string(temporaryCount++));
+    loop->temporaries->push_back(output.add(VariableStatement(name, value)));
+    loop->hoistedFallible = loop->hoistedFallible || !silent;
+    expression            = output.add(VariableExpression(name));
+    return true;
+}
+
+void Optimizer::observed()
+{
+    if (hoisting)
+    {
+        hoisting->failurePossible = false;
+    }
+}
+
+bool Optimizer::isLocal(NameId name) const
+{
+    return std::any_of(
+        scopes.begin(), scopes.end(), [&](const auto& scope) { return scope.count(name); });
+}
+
+bool Optimizer::isSilent(ExpressionId expr) const
+{
+    switch (expr.kind())
+    {
+        case ExpressionKind::Literal:
+            return true;
+        case ExpressionKind::Grouping:
+            return isSilent(source->get<GroupingExpression>(expr).getExpression());
+        case ExpressionKind::Variable:
+        {
+            const NameId name = source->get<VariableExpression>(expr).getName();
+            return isLocal(name) || defined.count(name);
+        }
+        case ExpressionKind::Binary:
+        {
+            const auto& binary = source->get<BinaryExpression>(expr);
+            return Operators::isEquality(binary.getOperator()) && isSilent(binary.getLeft()) &&
+                   isSilent(binary.getRight());
+        }
+        case ExpressionKind::Logical:
+        {
+            const auto& logical = source->get<LogicalExpression>(expr);
+            return isSilent(logical.getLeft()) && isSilent(logical.getRight());
+        }
+        default:
+            return false;
+    }
+}
+
+void Optimizer::summarize(ExpressionId expr, Summary& summary) const
+{
+    if (!expr)
+    {
+        return;
+    }
+    expr = unfused(*source, expr);
+    switch (expr.kind())
+    {
+        case ExpressionKind::Grouping:
+            summarize(source->get<GroupingExpression>(expr).getExpression(), summary);
+            break;
+        case ExpressionKind::Unary:
+            summarize(source->get<UnaryExpression>(expr).getRight(), summary);
+            break;
+        case ExpressionKind::Binary:
+        {
+            const auto& binary = source->get<BinaryExpression>(expr);
+            summarize(binary.getLeft(), summary);
+            summarize(binary.getRight(), summary);
+            break;
+        }
+        case ExpressionKind::Logical:
+        {
+            const auto& logical = source->get<LogicalExpression>(expr);
+            summarize(logical.getLeft(), summary);
+            summarize(logical.getRight(), summary);
+            break;
+        }
+        case ExpressionKind::Variable:
+            summary.reads.insert(source->get<VariableExpression>(expr).getName());
+            break;
+        case ExpressionKind::Assignment:
+        {
+            const auto& assignment = source->get<AssignmentExpression>(expr);
+            summary.writes.insert(assignment.getName());
+            summarize(assignment.getValue(), summary);
+            break;
+        }
+        case ExpressionKind::Call:
+        {
+            const auto& call = source->get<CallExpression>(expr);
+            summary.calls    = true;
+            summarize(call.getCallee(), summary);
+            for (ExpressionId argument : source->get(call.getArguments()))
+            {
+                summarize(argument, summary);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Optimizer::summarize(StatementId stmnt, Summary& summary) const
+{
+    if (!stmnt)
+    {
+        return;
+    }
+    switch (stmnt.kind())
+    {
+        case StatementKind::Print:
+            summarize(source->get<PrintStatement>(stmnt).getExpression(), summary);
+            break;
+        case StatementKind::Expression:
+            summarize(source->get<ExpressionStatement>(stmnt).getExpression(), summary);
+            break;
+        case StatementKind::Variable:
+        {
+            const auto& variable = source->get<VariableStatement>(stmnt);
+            summary.writes.insert(variable.getName());
+            summarize(variable.getInitializer(), summary);
+            break;
+        }
+        case StatementKind::Block:
+        {
+            const auto& block = source->get<BlockStatement>(stmnt);
+            for (StatementId inner : source->get(block.getStatements()))
+            {
+                summarize(inner, summary);
+            }
+            break;
+        }
+        case StatementKind::If:
+        {
+            const auto& branch = source->get<IfStatement>(stmnt);
+            summarize(branch.getCondition(), summary);
+            summarize(branch.getThenBranch(), summary);
+            summarize(branch.getElseBranch(), summary);
+            break;
+        }
+        case StatementKind::While:
+        {
+            const auto& loop = source->get<WhileStatement>(stmnt);
+            summarize(loop.getCondition(), summary);
+            summarize(loop.getBody(), summary);
+            break;
+        }
+        case StatementKind::For:
+        {
+            const auto& loop = source->get<ForStatement>(stmnt);
+            summarize(loop.getInitializer(), summary);
+            summarize(loop.getCondition(), summary);
+            summarize(loop.getIncrement(), summary);
+            summarize(loop.getBody(), summary);
+            break;
+        }
+        case StatementKind::FunctionDefinition:
+        {
+            const auto& function   = source->get<FunctionDefinitionStatement>(stmnt);
+            const auto  parameters = source->get(function.getParameters());
+            summary.writes.insert(function.getName());
+            summary.writes.insert(parameters.begin(), parameters.end());
+            summarize(function.getBody(), summary);
+            break;
+        }
+        case StatementKind::Return:
+            summarize(source->get<ReturnStatement>(stmnt).getExpression(), summary);
+            break;
+    }
+}
+
+void Optimizer::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& stmnt,
+                                                 Environment*                       env)
+{
+    declare(stmnt.getName(), Constant());
+
+    // Globals referred to from the body are attributed to the enclosing top-level function
+    const NameId enclosing = function;
+    if (scopes.empty())
+    {
+        function = stmnt.getName();
+    }
+
+    // The body runs at another time, in its own frame
+    Hoisting*    loop           = hoisting;
+    const size_t enclosingScope = functionScope;
+    hoisting                    = nullptr;
+    functionScope               = scopes.size();
+
+    const auto           names = source->get(stmnt.getParameters());
+    std::vector<NameId> parameters(names.begin(), names.end());
+
+    scopes.emplace_back();
+    declaredAhead.emplace_back();
+    for (NameId parameter : parameters)
+    {
+        declare(parameter, Constant());
+    }
+    auto body = rewrite(stmnt.getBody());
+    declaredAhead.pop_back();
+    scopes.pop_back();
+
+    function      = enclosing;
+    hoisting      = loop;
+    functionScope = enclosingScope;
+
+    const bool topLevel = scopes.empty();
+
+    statement = output.add(
+        FunctionDefinitionStatement(output, stmnt.getName(), output.add(parameters), body));
+
+    // Calls that follow the definition may be inlined, as it has run by then, unless a branch or
+    // loop may skip it
+    if (pass == Pass::Rewrite && topLevel && !conditional && !reassigned.count(stmnt.getName()))
+    {
+        inlinable[stmnt.getName()] = statement;
+    }
+}
+
+void Optimizer::visitReturnStatement(const ReturnStatement& stmnt, Environment* env)
+{
+    statement = output.add(ReturnStatement(rewrite(stmnt.getExpression())));
+}
+
+void Optimizer::visitLiteralExpression(const LiteralExpression& expr, Environment* env)
+{
+    expression = output.add(expr);
+}
+
+void Optimizer::visitUnaryExpression(const UnaryExpression& expr, Environment* env)
+{
+    auto right = rewrite(expr.getRight());
+
+    if (right.kind() == ExpressionKind::Literal)
+    {
+        try
+        {
+            expression = literal(Operators::unary(
+                expr.getOperator(), output.get<LiteralExpression>(right).getConstant()));
+            return;
+        }
+        catch (const std::runtime_error&)
+        {
+            // Left for the program to fail on when it runs
+        }
+    }
+    observed();
+    expression = output.add(UnaryExpression(expr.getOperator(), right));
+}
+
+void Optimizer::visitBinaryExpression(const BinaryExpression& expr, Environment* env)
+{
+    auto left  = rewrite(expr.getLeft());
+    auto right = rewrite(expr.getRight());
+
+    if (left.kind() == ExpressionKind::Literal && right.kind() == ExpressionKind::Literal)
+    {
+        try
+        {
+            expression = literal(
+                Operators::binary(expr.getOperator(),
+                                  output.get<LiteralExpression>(left).getConstant(),
+                                  output.get<LiteralExpression>(right).getConstant()));
+            return;
+        }
+        catch (const std::runtime_error&)
+        {
+            // Left for the program to fail on when it runs, e.g. a division by zero
+        }
+    }
+    if (!Operators::isEquality(expr.getOperator()))
+    {
+        observed();
+    }
+    const BinaryExpression binary(left, expr.getOperator(), right);
+    expression = output.add(binary);
+    if (ComparisonExpression::match(binary))
+    {
+        expression = output.add(ComparisonExpression(output, expression));
+    }
+}
+
+void Optimizer::visitGroupingExpression(const GroupingExpression& expr, Environment* env)
+{
+    auto inner = rewrite(expr.getExpression());
+    if (inner.kind() == ExpressionKind::Literal || inner.kind() == ExpressionKind::Variable)
+    {
+        expression = inner;
+        return;
+    }
+    expression = output.add(GroupingExpression(inner));
+}
+
+void Optimizer::visitVariableExpression(const VariableExpression& expr, Environment* env)
+{
+    if (inlining)
+    {
+        // A parameter of the function being inlined is replaced by its argument, which belongs to
+        // the call site
+        const int parameter = parameterIndex(output, inlining->parameters, expr.getName());
+        if (parameter != effect)
+        {
+            Inlining* enclosing = inlining;
+            inlining            = nullptr;
+            expression          = rewrite(enclosing->arguments[parameter]);
+            inlining            = enclosing;
+            return;
+        }
+    }
+
+    const Constant constant = lookup(expr.getName());
+    if (pass == Pass::Rewrite && constant)
+    {
+        expression = constant;
+        return;
+    }
+    expression = output.add(VariableExpression(expr.getName()));
+}
+
+void Optimizer::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+{
+    if (pass == Pass::FindAssignments)
+    {
+        reassigned.insert(expr.getName());
+    }
+    auto value = rewrite(expr.getValue());
+    lookup(expr.getName());
+    observed();
+
+    const AssignmentExpression assignment(expr.getName(), value);
+    expression = output.add(assignment);
+    if (CompoundAssignmentExpression::match(output, assignment))
+    {
+        expression = output.add(CompoundAssignmentExpression(output, expression));
+    }
+}
+
+void Optimizer::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    auto left = rewrite(expr.getLeft());
+
+    // The result is the left operand if it decides the outcome, and the right one otherwise
+    if (left.kind() == ExpressionKind::Literal)
+    {
+        const bool decided = output.get<LiteralExpression>(left).getConstant().isTruthy() ==
+                             (expr.getOperator() == LogicalOperator::Or);
+        expression = decided ? left : rewrite(expr.getRight());
+        return;
+    }
+
+    // Whether the right operand is evaluated depends on the left one
+    observed();
+    auto right = rewrite(expr.getRight());
+    expression = output.add(LogicalExpression(left, expr.getOperator(), right));
+}
+
+void Optimizer::visitCallExpression(const CallExpression& expr, Environment* env)
+{
+    // The callee is evaluated first, and may not be callable
+    observed();
+
+    // Copied first, as rewriting may add to the list they are in
+    const auto                ids = source->get(expr.getArguments());
+    std::vector<ExpressionId> arguments(ids.begin(), ids.end());
+    for (ExpressionId& argument : arguments)
+    {
+        argument = rewrite(argument);
+    }
+
+    const StatementId function = findInlinable(expr.getCallee(), arguments.size());
+    if (function && inlineCall(function, arguments))
+    {
+        return;
+    }
+    const ExpressionId callee = rewrite(expr.getCallee());
+    expression                = output.add(CallExpression(callee, output.add(arguments)));
+}
+
+// A fused node is rewritten from the expression it stands for, when a body that was already
+// rewritten is inlined
+void Optimizer::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                  Environment*                        env)
+{
+    rewrite(expr.getAssignment());
+}
+
+void Optimizer::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
+{
+    rewrite(expr.getComparison());
+}
+
+StatementId Optimizer::findInlinable(ExpressionId callee, size_t argumentCount) const
+{
+    if (callee.kind() != ExpressionKind::Variable || pass != Pass::Rewrite)
+    {
+        return {};
+    }
+    const NameId name = source->get<VariableExpression>(callee).getName();
+    if (isLocal(name))
+    {
+        return {};
+    }
+
+    auto it = inlinable.find(name);
+    if (it == inlinable.end() ||
+        output.get<FunctionDefinitionStatement>(it->second).getParameters().size != argumentCount)
+    {
+        return {};
+    }
+    return it->second;
+}
+
+bool Optimizer::inlineCall(StatementId definition, const std::vector<ExpressionId>& arguments)
+{
+    // Nothing is added to the output until the body is substituted, so `function` stays in place
+    const auto& function = output.get<FunctionDefinitionStatement>(definition);
+    const auto  body = output.get(output.get<BlockStatement>(function.getBody()).getStatements());
+    if (body.size() != 1 || body.front().kind() != StatementKind::Return)
+    {
+        return false;
+    }
+    const ExpressionId returned = output.get<ReturnStatement>(body.front()).getExpression();
+    if (!returned)
+    {
+        return false;
+    }
+
+    std::vector<int> events;
+    size_t           size  = 0;
+    bool             calls = false;
+    if (!trace(output, returned, function, events, size, calls) || size > inlineBudget)
+    {
+        return false;
+    }
+
+    // A call evaluates its arguments before the body, the inlined body where it uses each. A
+    // literal can be evaluated anywhere, and so can a local as long as nothing can assign it in
+    // between. The other arguments must each be used once, in order, before anything observable.
+    bool simple = !calls;
+    for (ExpressionId argument : arguments)
+    {
+        simple = simple && (argument.kind() == ExpressionKind::Literal ||
+                            argument.kind() == ExpressionKind::Variable);
+    }
+    std::vector<bool> movable;
+    std::vector<int>  expected;
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        const bool local = arguments[i].kind() == ExpressionKind::Variable &&
+                           isLocal(output.get<VariableExpression>(arguments[i]).getName());
+        movable.push_back(arguments[i].kind() == ExpressionKind::Literal || (simple && local));
+        if (!movable.back())
+        {
+            expected.push_back(static_cast<int>(i));
+        }
+    }
+
+    std::vector<int> reads;
+    bool             observed = false;
+    for (const int event : events)
+    {
+        if (event == effect)
+        {
+            observed = true;
+        }
+        else if (!movable[event])
+        {
+            if (observed)
+            {
+                return false;
+            }
+            reads.push_back(event);
+        }
+    }
+    if (reads != expected)
+    {
+        return false;
+    }
+
+    // The body's names are not the loop's, so nothing in it is hoisted
+    Inlining  inlined{function.getParameters(), arguments};
+    Inlining* enclosing = inlining;
+    Hoisting* loop      = hoisting;
+    inlining            = &inlined;
+    hoisting            = nullptr;
+    auto substituted    = rewriteOutput(returned);
+    inlining            = enclosing;
+    hoisting            = loop;
+
+    if (inlined.shadowed)
+    {
+        return false;
+    }
+    expression = substituted;
+    return true;
+}
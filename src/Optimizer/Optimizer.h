@@ -0,0 +1,240 @@
+#pragma once
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../Ast/Ast.h"
+#include "../Environment/Environment.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+#include "../Value/ConstantPool.h"
+
+// AST pass run between parsing and resolving when `-O` is given. It rebuilds the program with
+// constant subexpressions folded: an operator whose operands are literals is evaluated once, with
+// Operators::binary and Operators::unary, and replaced by a literal of its result. An operation
+// that would fail is left alone so it still fails at runtime.
+//
+// Variables that are never reassigned are propagated: a read of one whose initializer folded to a
+// literal becomes that literal. A name counts as reassigned if it is the target of any assignment
+// in the program, or is declared twice in the same scope (which reuses the variable). Globals are
+// only propagated into code that follows their declaration, since code before it may run first.
+//
+// Dead code is removed: the branch of an `if` whose condition folded to a constant that is not
+// taken, loops whose condition is falsy from the start, and statements that follow a `return`.
+// Top-level functions that the script never refers to, directly or through other functions it
+// uses, are dropped as well, so they are neither defined nor kept in memory.
+//
+// Calls to small top-level functions whose body is a single `return` are inlined, when the
+// function is never reassigned and the call follows its definition. Parameters are replaced by
+// the arguments, which requires that evaluating the arguments where the body uses them is
+// indistinguishable from evaluating them before the call, see inlineCall. Recursive functions are
+// never inlined.
+//
+// Expressions in a loop that are loop-invariant (they only read variables the loop never assigns
+// or declares, and make no call or assignment themselves) are hoisted into temporaries declared
+// in a block around the loop, so they are evaluated once. If the loop makes calls, only locals that
+// no closure captures count as unchanged. An invariant that may fail is only hoisted if it is
+// evaluated before anything observable on the first iteration: from the condition, or from the
+// start of the body, in which case the loop is guarded by an `if` on its condition so the
+// temporary is only evaluated when the body would be.
+//
+// Common idioms are fused into nodes the Evaluator runs directly: an increment or accumulation
+// `x = x + e` becomes a CompoundAssignmentExpression, and a comparison of variables and literals,
+// such as a loop condition, a ComparisonExpression.
+//
+// Like the Resolver, the program is walked twice: the first walk finds the reassigned names and
+// the second rewrites. Each walk builds a new Ast, which shares the names of the original.
+class Optimizer : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    // Literals produced by folding are added to `constants`
+    explicit Optimizer(ConstantPool& constants) : constants(constants) {}
+
+    Ast optimize(const Ast& program);
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    enum class Pass
+    {
+        FindAssignments,
+        Rewrite
+    };
+
+    // A literal of the output a variable always holds, or none if it may hold anything else.
+    // Literals carry no annotations, so one node can stand for the variable everywhere.
+    using Constant = ExpressionId;
+
+    ConstantPool& constants;
+
+    Pass pass = Pass::FindAssignments;
+
+    // The program rewritten by the current walk, and the Ast the nodes being rewritten are read
+    // from: the program, or the output itself when a rewritten node is rewritten again
+    Ast        output;
+    const Ast* source = nullptr;
+
+    // Value of a variable declared without an initializer
+    Constant nil;
+
+    // Innermost scope last; empty at the top level
+    std::vector<std::unordered_map<NameId, Constant>> scopes;
+
+    // Names each scope declares, found before rewriting it; a function nested in the scope may
+    // run before their declaration, so refers to them without knowing their value
+    std::vector<std::unordered_set<NameId>> declaredAhead;
+    std::unordered_map<NameId, Constant>    globals;
+
+    std::unordered_set<NameId> reassigned;
+
+    // Globals referred to from each top-level function, and under `script` from the rest of the
+    // script, which no name of the program can be interned as
+    static constexpr NameId                                script   = NameId{UINT32_MAX};
+    std::unordered_map<NameId, std::unordered_set<NameId>> references;
+    NameId                                                 function = script;
+
+    // Top-level functions of the output whose calls may be inlined, by name
+    std::unordered_map<NameId, StatementId> inlinable;
+
+    // Largest body, in expression nodes, that is inlined
+    static constexpr size_t inlineBudget = 16;
+
+    // The call being inlined, whose parameters are replaced while its body is rewritten
+    struct Inlining
+    {
+        IdList<NameId>                   parameters;
+        const std::vector<ExpressionId>& arguments;
+
+        // Whether a global the body refers to is hidden by a local at the call site
+        bool shadowed = false;
+    };
+    Inlining* inlining = nullptr;
+
+    // Names a fragment of the AST reads and writes (assigns or declares), and whether it calls
+    struct Summary
+    {
+        std::unordered_set<NameId> reads;
+        std::unordered_set<NameId> writes;
+        bool                       calls = false;
+    };
+
+    // The loop being rewritten, whose invariant expressions are hoisted
+    struct Hoisting
+    {
+        Summary loop;
+
+        // Declarations of the temporaries the invariants are hoisted into
+        std::vector<StatementId>* temporaries;
+
+        // Whether nothing that can fail or be observed has been evaluated yet on the first
+        // iteration, so an invariant that may fail can be hoisted; and whether one was
+        bool failurePossible = true;
+        bool hoistedFallible = false;
+    };
+    Hoisting* hoisting       = nullptr;
+    uint32_t  temporaryCount = 0;
+
+    // Locals referred to from a function nested in the one declaring them
+    std::unordered_set<NameId> captured;
+
+    // Index in `scopes` of the first scope of the function being rewritten
+    size_t functionScope = 0;
+
+    // Globals whose declaration certainly ran before the code being rewritten
+    std::unordered_set<NameId> defined;
+
+    // Statements the statement just rewritten must be preceded by in its sequence
+    std::vector<StatementId> preceding;
+
+    // Whether the statement being rewritten is the body of an `if` or a loop, so a variable it
+    // declares may never be initialized
+    bool conditional = false;
+
+    // Result of the last node visited, in the output
+    ExpressionId expression;
+    StatementId  statement;
+
+    // Rewrites a node of `source` into the output. A missing optional child stays missing.
+    ExpressionId rewrite(ExpressionId expr);
+    StatementId  rewrite(StatementId stmnt);
+
+    // Rewrites a sequence of statements, leaving out the ones removed
+    std::vector<StatementId> rewrite(std::span<const StatementId> statements);
+
+    // Rewrites `expr`, a node of the output, again
+    ExpressionId rewriteOutput(ExpressionId expr);
+
+    // Visits the node `id` of `source`
+    template <typename Id>
+    void dispatch(Id id);
+
+    // Rewrites the (optional) body of an `if` or a loop
+    StatementId rewriteBranch(StatementId stmnt);
+
+    // Rewrites a `while` loop, or a `for` loop if `isFor`, hoisting its invariants
+    void rewriteLoop(StatementId  initializer,
+                     ExpressionId condition,
+                     ExpressionId increment,
+                     StatementId  body,
+                     bool         isFor);
+
+    // Replaces `expr` in the loop being rewritten with a temporary, if it is invariant
+    bool hoist(ExpressionId expr);
+
+    // Notes that something that can fail or be observed was evaluated in the loop being rewritten
+    void observed();
+
+    bool isLocal(NameId name) const;
+
+    // Whether evaluating `expr` can neither fail nor be observed
+    bool isSilent(ExpressionId expr) const;
+
+    void summarize(ExpressionId expr, Summary& summary) const;
+    void summarize(StatementId stmnt, Summary& summary) const;
+
+    // Whether a statement that never runs can be left out of the program
+    static bool isRemovable(StatementId stmnt);
+
+    // Truthiness of a condition that folded to a literal
+    std::optional<bool> truthiness(ExpressionId condition) const;
+
+    void declare(NameId name, Constant constant);
+
+    // Finds the declaration `name` refers to, and notes references to globals
+    Constant lookup(NameId name);
+
+    // Function a call to `callee` with `argumentCount` arguments may be replaced with
+    StatementId findInlinable(ExpressionId callee, size_t argumentCount) const;
+
+    // Sets `expression` to the body of `function` with the (rewritten) arguments substituted, if
+    // that behaves exactly like the call
+    bool inlineCall(StatementId function, const std::vector<ExpressionId>& arguments);
+
+    // A literal expression of `value`, which is a number, string or boolean
+    ExpressionId literal(const Value& value);
+};
@@ -1,26 +1,31 @@
 #include "Parser.h"
 
-#include <memory>
+#include <cstdlib>
+#include <stdexcept>
 
 #include "ParserError.h"
 
-Parser::Parser(std::vector<Token>&& tokens) : tokens(std::move(tokens)) {}
+Parser::Parser(std::vector<Token>&& tokens, ConstantPool& constants)
+    : tokens(std::move(tokens)), constants(constants)
+{
+}
 
-std::vector<std::unique_ptr<Statement>> Parser::parse()
+Ast Parser::parse()
 {
-    std::vector<std::unique_ptr<Statement>> statements;
+    std::vector<StatementId> statements;
     while (!isAtEnd())
     {
         auto statement = parseStatement();
         if (statement)
         {
-            statements.push_back(std::move(statement));
+            statements.push_back(statement);
         }
     }
-    return statements;
+    ast.setStatements(statements);
+    return std::move(ast);
 }
 
-std::unique_ptr<Statement> Parser::parseStatement()
+StatementId Parser::parseStatement()
 {
     if (match({"var"}))
     {
@@ -57,35 +62,35 @@ std::unique_ptr<Statement> Parser::parseStatement()
     return parseExpressionStatement();
 }
 
-std::unique_ptr<PrintStatement> Parser::parsePrintStatement()
+StatementId Parser::parsePrintStatement()
 {
     auto expression = parseExpression();
     if (!match({";"}))
     {
         throw ParserError("Missing ';' after print statement.", peek().getLineNumber());
     }
-    return std::make_unique<PrintStatement>(std::move(expression));
+    return ast.add(PrintStatement(expression));
 }
 
-std::unique_ptr<ExpressionStatement> Parser::parseExpressionStatement()
+StatementId Parser::parseExpressionStatement()
 {
     auto expression = parseExpression();
     if (!expression)
     {
-        return nullptr;
+        return {};
     }
     if (isAtEnd())
     {
-        return std::make_unique<ExpressionStatement>(std::move(expression), true);
+        return ast.add(ExpressionStatement(expression, true));
     }
     if (!match({";"}))
     {
         throw ParserError("Missing ';' after expression statement.", peek().getLineNumber());
     }
-    return std::make_unique<ExpressionStatement>(std::move(expression), false);
+    return ast.add(ExpressionStatement(expression, false));
 }
 
-std::unique_ptr<VariableStatement> Parser::parseVariableStatement()
+StatementId Parser::parseVariableStatement()
 {
     Token var = advance();
 
@@ -94,9 +99,9 @@ std::unique_ptr<VariableStatement> Parser::parseVariableStatement()
         throw ParserError(" Expected variable name after 'var'.", peek().getLineNumber());
     }
 
-    std::string name = var.getLexeme();
+    NameId name = ast.intern(var.getLexeme());
 
-    std::unique_ptr<Expression> initializer = nullptr;
+    ExpressionId initializer;
     if (match({"="}))
     {
         initializer = parseExpression();
@@ -107,12 +112,12 @@ std::unique_ptr<VariableStatement> Parser::parseVariableStatement()
         throw ParserError("Missing ';' after variable declaration.", peek().getLineNumber());
     }
 
-    return std::make_unique<VariableStatement>(name, std::move(initializer));
+    return ast.add(VariableStatement(name, initializer));
 }
 
-std::unique_ptr<BlockStatement> Parser::parseBlockStatement()
+StatementId Parser::parseBlockStatement()
 {
-    std::vector<std::unique_ptr<Statement>> statements;
+    std::vector<StatementId> statements;
 
     while (!check("}") && !isAtEnd())
     {
@@ -124,10 +129,10 @@ std::unique_ptr<BlockStatement> Parser::parseBlockStatement()
         throw ParserError("Expected '}' to close block.", peek().getLineNumber());
     }
 
-    return std::make_unique<BlockStatement>(std::move(statements));
+    return ast.add(BlockStatement(ast.add(statements)));
 }
 
-std::unique_ptr<IfStatement> Parser::parseIfStatement()
+StatementId Parser::parseIfStatement()
 {
     if (!match({"("}))
     {
@@ -143,17 +148,16 @@ std::unique_ptr<IfStatement> Parser::parseIfStatement()
 
     auto thenBranch = parseStatement();
 
-    std::unique_ptr<Statement> elseBranch = nullptr;
+    StatementId elseBranch;
     if (match({"else"}))
     {
         elseBranch = parseStatement();
     }
 
-    return std::make_unique<IfStatement>(
-        std::move(condition), std::move(thenBranch), std::move(elseBranch));
+    return ast.add(IfStatement(condition, thenBranch, elseBranch));
 }
 
-std::unique_ptr<WhileStatement> Parser::parseWhileStatement()
+StatementId Parser::parseWhileStatement()
 {
     if (!match({"("}))
     {
@@ -169,10 +173,10 @@ std::unique_ptr<WhileStatement> Parser::parseWhileStatement()
 
     auto body = parseStatement();
 
-    return std::make_unique<WhileStatement>(std::move(condition), std::move(body));
+    return ast.add(WhileStatement(condition, body));
 }
 
-std::unique_ptr<ForStatement> Parser::parseForStatement()
+StatementId Parser::parseForStatement()
 {
     if (!match({"("}))
     {
@@ -180,7 +184,7 @@ std::unique_ptr<ForStatement> Parser::parseForStatement()
     }
 
     // Parse initializer
-    std::unique_ptr<Statement> initializer;
+    StatementId initializer;
     if (!match({";"}))
     {
         initializer = parseStatement();
@@ -191,7 +195,7 @@ std::unique_ptr<ForStatement> Parser::parseForStatement()
     }
 
     // Parse condition
-    std::unique_ptr<Expression> condition;
+    ExpressionId condition;
     if (!match({";"}))
     {
         condition = parseExpression();
@@ -206,7 +210,7 @@ std::unique_ptr<ForStatement> Parser::parseForStatement()
     }
 
     // Parse increment
-    std::unique_ptr<Expression> increment;
+    ExpressionId increment;
     if (!match({")"}))
     {
         increment = parseExpression();
@@ -227,17 +231,16 @@ std::unique_ptr<ForStatement> Parser::parseForStatement()
         throw ParserError("Expected statement after 'for' loop.", peek().getLineNumber());
     }
 
-    if (dynamic_cast<VariableStatement*>(body.get()))
+    if (body.kind() == StatementKind::Variable)
     {
         throw ParserError("Variable declaration not allowed inside 'for' loop.",
                           peek().getLineNumber());
     }
 
-    return std::make_unique<ForStatement>(
-        std::move(initializer), std::move(condition), std::move(increment), std::move(body));
+    return ast.add(ForStatement(initializer, condition, increment, body));
 }
 
-std::unique_ptr<FunctionDefinitionStatement> Parser::parseFunctionDefinitionStatement()
+StatementId Parser::parseFunctionDefinitionStatement()
 {
     Token name = advance();
     if (!match({"("}))
@@ -245,7 +248,7 @@ std::unique_ptr<FunctionDefinitionStatement> Parser::parseFunctionDefinitionStat
         throw ParserError("Expect '(' after function name.", peek().getLineNumber());
     }
 
-    std::vector<std::string> parameters;
+    std::vector<NameId> parameters;
     if (!check({")"}))
     {
         do
@@ -255,7 +258,7 @@ std::unique_ptr<FunctionDefinitionStatement> Parser::parseFunctionDefinitionStat
             {
                 throw ParserError("Expect a parameter name.", peek().getLineNumber());
             }
-            parameters.push_back(token.getLexeme());
+            parameters.push_back(ast.intern(token.getLexeme()));
         } while (match({","}));
     }
     if (!match({")"}))
@@ -267,15 +270,15 @@ std::unique_ptr<FunctionDefinitionStatement> Parser::parseFunctionDefinitionStat
         throw ParserError("Expect '{' before function body.", peek().getLineNumber());
     }
 
-    std::unique_ptr<BlockStatement> body = parseBlockStatement();
+    StatementId body = parseBlockStatement();
 
-    return std::make_unique<FunctionDefinitionStatement>(
-        std::move(name.getLexeme()), std::move(parameters), std::move(body));
+    return ast.add(
+        FunctionDefinitionStatement(ast, ast.intern(name.getLexeme()), ast.add(parameters), body));
 }
 
-std::unique_ptr<ReturnStatement> Parser::parseReturnStatement()
+StatementId Parser::parseReturnStatement()
 {
-    std::unique_ptr<Expression> returnExpr = nullptr;
+    ExpressionId returnExpr;
 
     if (!check(";"))
     {
@@ -287,45 +290,45 @@ std::unique_ptr<ReturnStatement> Parser::parseReturnStatement()
         throw ParserError("Expect ';' after return statement.", peek().getLineNumber());
     }
 
-    return std::make_unique<ReturnStatement>(std::move(returnExpr));
+    return ast.add(ReturnStatement(returnExpr));
 }
 
-std::unique_ptr<Expression> Parser::parseExpression()
+ExpressionId Parser::parseExpression()
 {
     return parseOr();
 }
 
-std::unique_ptr<Expression> Parser::parseOr()
+ExpressionId Parser::parseOr()
 {
     auto left = parseAnd();  // OR has lower precedence than AND
 
     while (match({"or"}))
     {
         Token operatorToken = tokens[current - 1];  // The matched 'or' operator
+        auto  op            = *Operators::toLogicalOperator(operatorToken.getLexeme());
         auto  right         = parseOr();
-        left                = std::make_unique<LogicalExpression>(
-            std::move(left), operatorToken.getLexeme(), std::move(right));
+        left = ast.add(LogicalExpression(left, op, right));
     }
 
     return left;
 }
 
-std::unique_ptr<Expression> Parser::parseAnd()
+ExpressionId Parser::parseAnd()
 {
     auto left = parseAssignment();
 
     while (match({"and"}))
     {
         Token operatorToken = tokens[current - 1];
+        auto  op            = *Operators::toLogicalOperator(operatorToken.getLexeme());
         auto  right         = parseAnd();
-        left                = std::make_unique<LogicalExpression>(
-            std::move(left), operatorToken.getLexeme(), std::move(right));
+        left = ast.add(LogicalExpression(left, op, right));
     }
 
     return left;
 }
 
-std::unique_ptr<Expression> Parser::parseAssignment()
+ExpressionId Parser::parseAssignment()
 {
     auto left = parseEquality();
     if (match({"="}))
@@ -334,9 +337,10 @@ std::unique_ptr<Expression> Parser::parseAssignment()
         auto  right  = parseAssignment();
 
         // Ensure that left is a valid variable (identifier)
-        if (auto variable = dynamic_cast<VariableExpression*>(left.get()))
+        if (left.kind() == ExpressionKind::Variable)
         {
-            return std::make_unique<AssignmentExpression>(variable->getName(), std::move(right));
+            return ast.add(
+                AssignmentExpression(ast.get<VariableExpression>(left).getName(), right));
         }
 
         throw ParserError("Invalid assignment target.", peek().getLineNumber());
@@ -345,48 +349,49 @@ std::unique_ptr<Expression> Parser::parseAssignment()
     return left;
 }
 
-std::unique_ptr<Expression> Parser::parseEquality()
+ExpressionId Parser::parseEquality()
 {
     return parseBinary([this]() { return parseComparison(); }, {"==", "!="});
 }
 
-std::unique_ptr<Expression> Parser::parseComparison()
+ExpressionId Parser::parseComparison()
 {
     return parseBinary([this]() { return parseTerm(); }, {">", "<", ">=", "<="});
 }
 
-std::unique_ptr<Expression> Parser::parseTerm()
+ExpressionId Parser::parseTerm()
 {
     return parseBinary([this]() { return parseFactor(); }, {"+", "-"});
 }
 
-std::unique_ptr<Expression> Parser::parseFactor()
+ExpressionId Parser::parseFactor()
 {
     return parseBinary([this]() { return parseUnary(); }, {"*", "/"});
 }
 
-std::unique_ptr<Expression> Parser::parseUnary()
+ExpressionId Parser::parseUnary()
 {
     if (match({"!", "-"}))
     {
         Token operatorToken = tokens[current - 1];  // The matched operator
         auto  right         = parseUnary();         // Recursively parse the operand
-        return std::make_unique<UnaryExpression>(operatorToken.getLexeme(), std::move(right));
+        return ast.add(
+            UnaryExpression(*Operators::toUnaryOperator(operatorToken.getLexeme()), right));
     }
     return parseCall(parsePrimary());
 }
 
-std::unique_ptr<GroupingExpression> Parser::parseGrouping()
+ExpressionId Parser::parseGrouping()
 {
     auto expression = parseExpression();
     if (!match({")"}))
     {
         throw ParserError("Missing closing parenthesis", peek().getLineNumber());
     }
-    return std::make_unique<GroupingExpression>(std::move(expression));
+    return ast.add(GroupingExpression(expression));
 }
 
-std::unique_ptr<LiteralExpression> Parser::parseLiteral()
+ExpressionId Parser::parseLiteral()
 {
     Token literalToken = advance();
 
@@ -394,33 +399,42 @@ std::unique_ptr<LiteralExpression> Parser::parseLiteral()
     auto literalValue  = literalToken.getLiteral();
     auto tokenType     = literalToken.getType();
 
-    std::unique_ptr<LiteralExpression> literalExp;
     switch (tokenType)
     {
         case TokenType::NumberLiteral:
-            literalExp = std::make_unique<LiteralExpression>(literalValue, LiteralType::Number);
-            break;
+        {
+            // strtod, unlike stod, rounds a literal out of a double's range to infinity or zero
+            char*        end    = nullptr;
+            const double number = std::strtod(literalValue.c_str(), &end);
+            if (end == literalValue.c_str())
+            {
+                throw ParserError("Invalid number literal: " + literalValue,
+                                  literalToken.getLineNumber());
+            }
+            return ast.add(LiteralExpression(
+                ast.intern(literalValue), LiteralType::Number, constants.addNumber(number)));
+        }
         case TokenType::BooleanLiteral:
-            literalExp = std::make_unique<LiteralExpression>(literalLexeme, LiteralType::Boolean);
-            break;
+            return ast.add(LiteralExpression(ast.intern(literalLexeme),
+                                             LiteralType::Boolean,
+                                             constants.addBoolean(literalLexeme == "true")));
         case TokenType::NilLiteral:
-            literalExp = std::make_unique<LiteralExpression>(literalLexeme, LiteralType::Nil);
-            break;
+            return ast.add(
+                LiteralExpression(ast.intern(literalLexeme), LiteralType::Nil, constants.addNil()));
         case TokenType::StringLiteral:
             if (literalToken.hasError())
             {
                 throw ParserError("Unterminated String Literal.", peek().getLineNumber());
             }
-            literalExp = std::make_unique<LiteralExpression>(literalValue, LiteralType::String);
-            break;
+            return ast.add(LiteralExpression(
+                ast.intern(literalValue), LiteralType::String, constants.addString(literalValue)));
         default:
             throw ParserError(literalLexeme + "is not a Literal Token ", peek().getLineNumber());
     }
-    return literalExp;
 }
 
 // Parse a primary expression (numbers, grouped expressions, and unary operators)
-std::unique_ptr<Expression> Parser::parsePrimary()
+ExpressionId Parser::parsePrimary()
 {
     Token token = peek();
 
@@ -437,23 +451,23 @@ std::unique_ptr<Expression> Parser::parsePrimary()
     if (token.getType() == TokenType::Identifier)
     {
         advance();
-        std::unique_ptr<Expression> expr = std::make_unique<VariableExpression>(token.getLexeme());
+        ExpressionId expr = ast.add(VariableExpression(ast.intern(token.getLexeme())));
 
         // If the next token is '(', it means we're parsing a function call
         if (check({"("}))
         {
-            expr = parseCall(std::move(expr));
+            expr = parseCall(expr);
         }
         return expr;
     }
     throw ParserError("Unexpected Token: " + peek().getLexeme(), peek().getLineNumber());
 }
 
-std::unique_ptr<Expression> Parser::parseCall(std::unique_ptr<Expression> callee)
+ExpressionId Parser::parseCall(ExpressionId callee)
 {
     while (match({"("}))
     {
-        std::vector<std::unique_ptr<Expression>> arguments;
+        std::vector<ExpressionId> arguments;
 
         if (!check(")"))
         {
@@ -468,23 +482,22 @@ std::unique_ptr<Expression> Parser::parseCall(std::unique_ptr<Expression> callee
             throw ParserError("Expected ')' after function arguments.", peek().getLineNumber());
         }
 
-        callee = std::make_unique<CallExpression>(std::move(callee), std::move(arguments));
+        callee = ast.add(CallExpression(callee, ast.add(arguments)));
     }
     return callee;
 }
 
-std::unique_ptr<Expression> Parser::parseBinary(
-    std::function<std::unique_ptr<Expression>()> subParser,
-    const std::vector<std::string>&              operators)
+ExpressionId Parser::parseBinary(std::function<ExpressionId()>   subParser,
+                                 const std::vector<std::string>& operators)
 {
     auto left = subParser();
 
     while (match(operators))
     {
         Token operatorToken = tokens[current - 1];  // The matched operator
+        auto  op            = *Operators::toBinaryOperator(operatorToken.getLexeme());
         auto  right         = subParser();
-        left                = std::make_unique<BinaryExpression>(
-            std::move(left), operatorToken.getLexeme(), std::move(right));
+        left = ast.add(BinaryExpression(left, op, right));
     }
 
     return left;
@@ -2,59 +2,63 @@
 #include <cstddef>
 #include <functional>
 #include <iostream>
-#include <memory>
 #include <vector>
 
-#include "../Expression/Expression.h"
-#include "../Statement/Statement.h"
+#include "../Ast/Ast.h"
 #include "../Token/Token.h"
+#include "../Value/ConstantPool.h"
 
 // The Parser class handles parsing tokens into an Abstract Syntax Tree (AST) consisting of
 // Statements and Expressions
 class Parser
 {
    public:
-    explicit Parser(std::vector<Token>&& tokens);
+    // Literal values are converted once and stored in `constants`, which must outlive the AST
+    Parser(std::vector<Token>&& tokens, ConstantPool& constants);
 
-    // Main parse method: returns a list of parsed statements
-    std::vector<std::unique_ptr<Statement>> parse();
+    // Main parse method: returns the AST of the parsed statements
+    Ast parse();
 
    private:
     std::vector<Token> tokens;
 
+    Ast ast;
+
+    ConstantPool& constants;
+
     size_t current = 0;
 
     // Recursive descent parsing methods for statements
-    std::unique_ptr<Statement>                   parseStatement();
-    std::unique_ptr<PrintStatement>              parsePrintStatement();
-    std::unique_ptr<ExpressionStatement>         parseExpressionStatement();
-    std::unique_ptr<VariableStatement>           parseVariableStatement();
-    std::unique_ptr<BlockStatement>              parseBlockStatement();
-    std::unique_ptr<IfStatement>                 parseIfStatement();
-    std::unique_ptr<WhileStatement>              parseWhileStatement();
-    std::unique_ptr<ForStatement>                parseForStatement();
-    std::unique_ptr<FunctionDefinitionStatement> parseFunctionDefinitionStatement();
-    std::unique_ptr<ReturnStatement>             parseReturnStatement();
+    StatementId parseStatement();
+    StatementId parsePrintStatement();
+    StatementId parseExpressionStatement();
+    StatementId parseVariableStatement();
+    StatementId parseBlockStatement();
+    StatementId parseIfStatement();
+    StatementId parseWhileStatement();
+    StatementId parseForStatement();
+    StatementId parseFunctionDefinitionStatement();
+    StatementId parseReturnStatement();
 
     // Recursive descent parsing methods for expressions
-    std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseOr();
-    std::unique_ptr<Expression> parseAnd();
-    std::unique_ptr<Expression> parseAssignment();
-    std::unique_ptr<Expression> parseEquality();
-    std::unique_ptr<Expression> parseComparison();
-    std::unique_ptr<Expression> parseTerm();
-    std::unique_ptr<Expression> parseFactor();
-    std::unique_ptr<Expression> parseUnary();
-    std::unique_ptr<Expression> parsePrimary();
-    std::unique_ptr<Expression> parseCall(std::unique_ptr<Expression> callee);
+    ExpressionId parseExpression();
+    ExpressionId parseOr();
+    ExpressionId parseAnd();
+    ExpressionId parseAssignment();
+    ExpressionId parseEquality();
+    ExpressionId parseComparison();
+    ExpressionId parseTerm();
+    ExpressionId parseFactor();
+    ExpressionId parseUnary();
+    ExpressionId parsePrimary();
+    ExpressionId parseCall(ExpressionId callee);
 
-    std::unique_ptr<GroupingExpression> parseGrouping();
-    std::unique_ptr<LiteralExpression>  parseLiteral();
+    ExpressionId parseGrouping();
+    ExpressionId parseLiteral();
 
     // Helper function for parsing binary expressions
-    std::unique_ptr<Expression> parseBinary(std::function<std::unique_ptr<Expression>()> subParser,
-                                            const std::vector<std::string>&              operators);
+    ExpressionId parseBinary(std::function<ExpressionId()>   subParser,
+                             const std::vector<std::string>& operators);
 
     // Helper methods
     Token advance();
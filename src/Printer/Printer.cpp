@@ -1,29 +1,248 @@
 #include "Printer.h"
 
+#include <string>
+
 void Printer::visitLiteralExpression(const LiteralExpression& expr, Environment* env)
 {
-    std::cout << expr.getValue();
+    // Quoted in programs so a string cannot be mistaken for a variable
+    if (mode == Mode::Program && expr.getType() == LiteralType::String)
+    {
+        std::cout << '"' << ast.getString(expr.getText()) << '"';
+        return;
+    }
+    std::cout << ast.getString(expr.getText());
 }
 
 void Printer::visitGroupingExpression(const GroupingExpression& expr, Environment* env)
 {
     std::cout << "(group ";
-    expr.getExpression()->accept(*this, env);
+    visit(*this, ast, expr.getExpression(), env);
     std::cout << ")";
 }
 
 void Printer::visitUnaryExpression(const UnaryExpression& expr, Environment* env)
 {
-    std::cout << "(" << expr.getOperator() << " ";
-    expr.getRight()->accept(*this, env);
+    std::cout << "(" << Operators::toLexeme(expr.getOperator()) << " ";
+    visit(*this, ast, expr.getRight(), env);
     std::cout << ")";
 }
 
 void Printer::visitBinaryExpression(const BinaryExpression& expr, Environment* env)
 {
-    std::cout << "(" << expr.getOperator() << " ";
-    expr.getLeft()->accept(*this, env);
+    std::cout << "(" << Operators::toLexeme(expr.getOperator()) << " ";
+    visit(*this, ast, expr.getLeft(), env);
+    std::cout << " ";
+    visit(*this, ast, expr.getRight(), env);
+    std::cout << ")";
+}
+
+void Printer::visitVariableExpression(const VariableExpression& expr, Environment* env)
+{
+    if (mode == Mode::Program)
+    {
+        std::cout << ast.getString(expr.getName());
+    }
+}
+
+void Printer::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+{
+    if (mode != Mode::Program)
+    {
+        return;
+    }
+    std::cout << "(= " << ast.getString(expr.getName()) << " ";
+    visit(*this, ast, expr.getValue(), env);
+    std::cout << ")";
+}
+
+void Printer::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    if (mode != Mode::Program)
+    {
+        return;
+    }
+    std::cout << "(" << Operators::toLexeme(expr.getOperator()) << " ";
+    visit(*this, ast, expr.getLeft(), env);
+    std::cout << " ";
+    visit(*this, ast, expr.getRight(), env);
+    std::cout << ")";
+}
+
+void Printer::visitCallExpression(const CallExpression& expr, Environment* env)
+{
+    if (mode != Mode::Program)
+    {
+        return;
+    }
+    std::cout << "(call ";
+    visit(*this, ast, expr.getCallee(), env);
+    for (ExpressionId argument : ast.get(expr.getArguments()))
+    {
+        operand(argument);
+    }
+    std::cout << ")";
+}
+
+void Printer::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                Environment*                        env)
+{
+    if (mode != Mode::Program)
+    {
+        visit(*this, ast, expr.getAssignment(), env);
+        return;
+    }
+    std::cout << "(" << Operators::toLexeme(expr.getOperator()) << "= "
+              << ast.getString(ast.get<VariableExpression>(expr.getTarget()).getName()) << " ";
+    visit(*this, ast, expr.getOperand().expression, env);
+    std::cout << ")";
+}
+
+void Printer::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
+{
+    if (mode != Mode::Program)
+    {
+        visit(*this, ast, expr.getComparison(), env);
+        return;
+    }
+    const auto& comparison = ast.get<BinaryExpression>(expr.getComparison());
+    std::cout << "(compare " << Operators::toLexeme(comparison.getOperator()) << " ";
+    visit(*this, ast, comparison.getLeft(), env);
     std::cout << " ";
-    expr.getRight()->accept(*this, env);
+    visit(*this, ast, comparison.getRight(), env);
+    std::cout << ")";
+}
+
+void Printer::print()
+{
+    for (StatementId statement : ast.getStatements())
+    {
+        visit(*this, ast, statement);
+    }
+    std::cout << std::endl;
+}
+
+void Printer::newLine()
+{
+    if (!firstLine)
+    {
+        std::cout << "\n";
+    }
+    firstLine = false;
+    std::cout << std::string(2 * indentation, ' ');
+}
+
+void Printer::nested(StatementId statement)
+{
+    ++indentation;
+    visit(*this, ast, statement);
+    --indentation;
+}
+
+void Printer::operand(ExpressionId expr)
+{
+    if (expr)
+    {
+        std::cout << " ";
+        visit(*this, ast, expr);
+    }
+}
+
+void Printer::visitPrintStatement(const PrintStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(print";
+    operand(statement.getExpression());
+    std::cout << ")";
+}
+
+void Printer::visitExpressionStatement(const ExpressionStatement& statement, Environment* env)
+{
+    newLine();
+    visit(*this, ast, statement.getExpression(), env);
+}
+
+void Printer::visitVariableStatement(const VariableStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(var " << ast.getString(statement.getName());
+    operand(statement.getInitializer());
+    std::cout << ")";
+}
+
+void Printer::visitBlockStatement(const BlockStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(block";
+    for (StatementId inner : ast.get(statement.getStatements()))
+    {
+        nested(inner);
+    }
+    std::cout << ")";
+}
+
+void Printer::visitIfStatement(const IfStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(if";
+    operand(statement.getCondition());
+    nested(statement.getThenBranch());
+    if (statement.getElseBranch())
+    {
+        nested(statement.getElseBranch());
+    }
+    std::cout << ")";
+}
+
+void Printer::visitWhileStatement(const WhileStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(while";
+    operand(statement.getCondition());
+    nested(statement.getBody());
+    std::cout << ")";
+}
+
+void Printer::visitForStatement(const ForStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(for";
+    if (statement.getInitializer())
+    {
+        nested(statement.getInitializer());
+    }
+    ++indentation;
+    newLine();
+    std::cout << "(condition";
+    operand(statement.getCondition());
+    std::cout << ")";
+    newLine();
+    std::cout << "(increment";
+    operand(statement.getIncrement());
+    std::cout << ")";
+    --indentation;
+    nested(statement.getBody());
+    std::cout << ")";
+}
+
+void Printer::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
+                                               Environment*                       env)
+{
+    newLine();
+    std::cout << "(fun " << ast.getString(statement.getName()) << " (";
+    const auto parameters = ast.get(statement.getParameters());
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        std::cout << (i > 0 ? " " : "") << ast.getString(parameters[i]);
+    }
+    std::cout << ")";
+    nested(statement.getBody());
+    std::cout << ")";
+}
+
+void Printer::visitReturnStatement(const ReturnStatement& statement, Environment* env)
+{
+    newLine();
+    std::cout << "(return";
+    operand(statement.getExpression());
     std::cout << ")";
 }
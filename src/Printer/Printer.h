@@ -1,23 +1,71 @@
 #pragma once
 #include <iostream>
 
+#include "../Ast/Ast.h"
 #include "../Environment/Environment.h"
-#include "../Expression/Expression.h"
 #include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
 
-class Printer : public ExpressionVisitor
+// Prints expressions as parenthesized prefix forms. Whole programs, as `--dump-optimized` shows
+// them, print one statement per line, with the statements of a block indented under it.
+class Printer final : public ExpressionVisitor<void>, public StatementVisitor<void>
 {
    public:
+    enum class Mode
+    {
+        // The `parse` command: variables, assignments, logical expressions and calls print nothing
+        Expressions,
+
+        // `--dump-optimized`: every node is printed, string literals are quoted, and fused nodes
+        // are told apart from the generic ones they replace
+        Program
+    };
+
+    // Prints nodes of `ast`
+    explicit Printer(const Ast& ast, Mode mode = Mode::Expressions) : ast(ast), mode(mode) {}
+
+    // Prints the whole program
+    void print();
+
     // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
     // Expression visitor methods
     void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
     void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
     void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
     void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
-
-    void visitVariableExpression(const VariableExpression& expr, Environment* env) override {};
-    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override {};
-    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override {};
-    void visitCallExpression(const CallExpression& expr, Environment* env) override {};
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
     // clang-format on
+
+   private:
+    const Ast& ast;
+
+    const Mode mode;
+
+    int  indentation = 0;
+    bool firstLine   = true;
+
+    // Starts a new line for a statement
+    void newLine();
+
+    // A statement nested in another, e.g. a loop body, on its own indented line
+    void nested(StatementId statement);
+
+    // ` expr`, or nothing for a missing optional expression
+    void operand(ExpressionId expr);
 };
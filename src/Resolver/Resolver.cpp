@@ -0,0 +1,337 @@
+#include "Resolver.h"
+
+#include <algorithm>
+
+void Resolver::resolve(Ast& program)
+{
+    ast = &program;
+    for (Pass current : {Pass::FindCaptures, Pass::AssignLocations})
+    {
+        pass = current;
+        for (StatementId statement : program.getStatements())
+        {
+            visit(*this, program, statement);
+        }
+    }
+}
+
+void Resolver::beginScope(ScopeLayout& layout)
+{
+    if (pass == Pass::FindCaptures)
+    {
+        layout = ScopeLayout();
+    }
+
+    // A scope starts right after the enclosing scope of the same function
+    const size_t function = functions.size() - 1;
+    layout.slotCount      = 0;
+    layout.frameOffset    = 0;
+    if (!scopes.empty() && scopes.back().function == function)
+    {
+        layout.frameOffset = scopes.back().layout.frameOffset + scopes.back().layout.slotCount;
+    }
+    scopes.push_back({{}, layout, function});
+}
+
+void Resolver::endScope()
+{
+    scopes.pop_back();
+}
+
+VariableLocation Resolver::declare(NameId name)
+{
+    if (scopes.empty())
+    {
+        return {VariableLocation::Kind::Global, globals.indexOf(ast->getString(name))};
+    }
+
+    Binding& binding = bind(name);
+    if (!binding.declared)
+    {
+        binding.declared    = true;
+        binding.conditional = conditional;
+    }
+    else if (!conditional)
+    {
+        binding.conditional = false;
+    }
+    return local(scopes.back(), binding.slot);
+}
+
+Resolver::Binding& Resolver::bind(NameId name)
+{
+    Scope&       scope  = scopes.back();
+    ScopeLayout& layout = scope.layout;
+
+    auto it = scope.bindings.find(name);
+    if (it == scope.bindings.end())
+    {
+        it = scope.bindings.emplace(name, Binding{layout.slotCount++, false, false}).first;
+        if (pass == Pass::FindCaptures)
+        {
+            layout.captured.push_back(false);
+        }
+    }
+
+    Function& function = functions.back();
+    function.frameSize = std::max(function.frameSize, layout.frameOffset + layout.slotCount);
+    return it->second;
+}
+
+VariableLocation Resolver::lookup(NameId name, size_t depth)
+{
+    const size_t function = functions.size() - 1;
+    while (depth-- > 0)
+    {
+        Scope& scope   = scopes[depth];
+        auto   binding = scope.bindings.find(name);
+        if (binding == scope.bindings.end())
+        {
+            continue;
+        }
+
+        // Code of the declaring function runs in order, so it cannot see a declaration ahead
+        const bool declared = binding->second.declared;
+        if (!declared && scope.function == function)
+        {
+            continue;
+        }
+
+        const uint32_t   slot = binding->second.slot;
+        VariableLocation location;
+        if (scope.function == function)
+        {
+            location = local(scope, slot);
+        }
+        else if (pass == Pass::FindCaptures)
+        {
+            // Referenced from a nested function, so the variable must outlive its frame
+            scope.layout.captured[slot] = true;
+        }
+        else
+        {
+            const uint32_t frameIndex = scope.layout.frameOffset + slot;
+            location.kind             = VariableLocation::Kind::Capture;
+            location.index            = capture(function, scope.function, frameIndex);
+        }
+
+        // Until a skipped or later declaration runs, the name still refers to whatever it did
+        if (binding->second.conditional || !declared)
+        {
+            const VariableLocation fallback = lookup(name, depth);
+            if (pass == Pass::AssignLocations)
+            {
+                location.fallback = ast->addFallback(fallback);
+            }
+        }
+        return location;
+    }
+    return {VariableLocation::Kind::Global, globals.indexOf(ast->getString(name))};
+}
+
+void Resolver::resolveBranch(StatementId statement)
+{
+    const bool enclosing = conditional;
+    conditional          = true;
+    visit(*this, *ast, statement);
+    conditional = enclosing;
+}
+
+VariableLocation Resolver::local(const Scope& scope, uint32_t slot) const
+{
+    const auto kind = scope.layout.captured[slot] ? VariableLocation::Kind::Cell
+                                                  : VariableLocation::Kind::Frame;
+    return {kind, scope.layout.frameOffset + slot};
+}
+
+uint32_t Resolver::capture(size_t function, size_t declaringFunction, uint32_t frameIndex)
+{
+    Capture source{true, frameIndex};
+    if (function - 1 != declaringFunction)
+    {
+        source = {false, capture(function - 1, declaringFunction, frameIndex)};
+    }
+
+    auto& captures = functions[function].captures;
+    for (uint32_t i = 0; i < captures.size(); ++i)
+    {
+        if (captures[i].fromFrame == source.fromFrame && captures[i].index == source.index)
+        {
+            return i;
+        }
+    }
+    captures.push_back(source);
+    return captures.size() - 1;
+}
+
+void Resolver::visitPrintStatement(const PrintStatement& statement, Environment* env)
+{
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+    }
+}
+
+void Resolver::visitExpressionStatement(const ExpressionStatement& statement, Environment* env)
+{
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+    }
+}
+
+void Resolver::visitVariableStatement(const VariableStatement& statement, Environment* env)
+{
+    // The initializer is resolved first, so `var a = a;` reads the enclosing `a`
+    if (statement.getInitializer())
+    {
+        visit(*this, *ast, statement.getInitializer());
+    }
+    statement.resolve(declare(statement.getName()));
+}
+
+void Resolver::visitBlockStatement(const BlockStatement& statement, Environment* env)
+{
+    // A block's own declarations run whenever the block does
+    const bool enclosing = conditional;
+    conditional          = false;
+    beginScope(statement.getMutableScope());
+    for (StatementId stmnt : ast->get(statement.getStatements()))
+    {
+        forEachDeclaredName(*ast, stmnt, [&](NameId name) { bind(name); });
+    }
+    for (StatementId stmnt : ast->get(statement.getStatements()))
+    {
+        visit(*this, *ast, stmnt);
+    }
+    endScope();
+    conditional = enclosing;
+}
+
+void Resolver::visitIfStatement(const IfStatement& statement, Environment* env)
+{
+    visit(*this, *ast, statement.getCondition());
+    resolveBranch(statement.getThenBranch());
+    if (statement.getElseBranch())
+    {
+        resolveBranch(statement.getElseBranch());
+    }
+}
+
+void Resolver::visitWhileStatement(const WhileStatement& statement, Environment* env)
+{
+    visit(*this, *ast, statement.getCondition());
+    resolveBranch(statement.getBody());
+}
+
+void Resolver::visitForStatement(const ForStatement& statement, Environment* env)
+{
+    // The initializer runs in the enclosing scope rather than a scope of its own
+    if (statement.getInitializer())
+    {
+        visit(*this, *ast, statement.getInitializer());
+    }
+    if (statement.getCondition())
+    {
+        visit(*this, *ast, statement.getCondition());
+    }
+    resolveBranch(statement.getBody());
+    if (statement.getIncrement())
+    {
+        visit(*this, *ast, statement.getIncrement());
+    }
+}
+
+void Resolver::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
+                                                Environment*                       env)
+{
+    // Declared before the body is resolved so the function can refer to itself
+    VariableLocation location = declare(statement.getName());
+
+    const bool enclosing = conditional;
+    conditional          = false;
+    functions.emplace_back();
+    beginScope(statement.getMutableParameterScope());
+
+    std::vector<uint32_t> parameterSlots;
+    for (NameId parameter : ast->get(statement.getParameters()))
+    {
+        parameterSlots.push_back(declare(parameter).index);
+    }
+    visit(*this, *ast, statement.getBody());
+
+    endScope();
+    Function& function = functions.back();
+    statement.resolve(
+        location, std::move(parameterSlots), function.frameSize, std::move(function.captures));
+    functions.pop_back();
+    conditional = enclosing;
+}
+
+void Resolver::visitReturnStatement(const ReturnStatement& statement, Environment* env)
+{
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+
+        if (functions.size() > 1 && statement.getExpression().kind() == ExpressionKind::Call)
+        {
+            statement.markTailCall();
+        }
+    }
+}
+
+void Resolver::visitLiteralExpression(const LiteralExpression& expr, Environment* env) {}
+
+void Resolver::visitUnaryExpression(const UnaryExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getRight());
+}
+
+void Resolver::visitBinaryExpression(const BinaryExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getLeft());
+    visit(*this, *ast, expr.getRight());
+}
+
+void Resolver::visitGroupingExpression(const GroupingExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getExpression());
+}
+
+void Resolver::visitVariableExpression(const VariableExpression& expr, Environment* env)
+{
+    expr.resolve(lookup(expr.getName()));
+}
+
+void Resolver::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getValue());
+    expr.resolve(lookup(expr.getName()));
+}
+
+void Resolver::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getLeft());
+    visit(*this, *ast, expr.getRight());
+}
+
+void Resolver::visitCallExpression(const CallExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getCallee());
+    for (ExpressionId argument : ast->get(expr.getArguments()))
+    {
+        visit(*this, *ast, argument);
+    }
+}
+
+void Resolver::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                 Environment*                        env)
+{
+    visit(*this, *ast, expr.getAssignment());
+}
+
+void Resolver::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getComparison());
+}
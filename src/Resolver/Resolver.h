@@ -0,0 +1,132 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "../Ast/Ast.h"
+#include "../Environment/Environment.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+
+// Static pass run between parsing and evaluation. It mirrors the scopes the Evaluator creates at
+// runtime (one per block, plus one for a function's parameters) and annotates every variable
+// declaration, read and assignment with its VariableLocation, so the Evaluator never looks a name
+// up by string. Names that are not declared in any enclosing local scope are globals.
+//
+// The program is walked twice. The first walk is an escape analysis that marks every variable
+// referenced from a nested function as captured. The second assigns locations: locals are laid out
+// in their function's frame on the Evaluator's stack, captured ones are boxed in a Cell, and each
+// function records the Cells its closures capture, so a closure keeps alive only the variables it
+// actually refers to.
+//
+// A local declared only by the body of an if or loop may never be defined. Its reads and
+// assignments carry a fallback location, which they use instead while the local is undefined.
+// A block declares all its names before resolving anything in it, so a function can refer to a
+// local declared later in an enclosing block; as it may run before that declaration does, such a
+// reference carries a fallback too.
+class Resolver : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    explicit Resolver(GlobalEnvironment& globals) : globals(globals) {}
+
+    // Annotates the nodes of `program`, which keeps the fallback locations
+    void resolve(Ast& program);
+
+    // Number of frame slots the top-level code needs for its (uncaptured) blocks
+    uint32_t getFrameSize() const { return functions.front().frameSize; }
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    enum class Pass
+    {
+        FindCaptures,
+        AssignLocations
+    };
+
+    struct Binding
+    {
+        uint32_t slot;
+
+        // Only declared by a statement a branch or loop may skip so far
+        bool conditional;
+
+        // Whether its declaration has been resolved, rather than only found ahead of it
+        bool declared;
+    };
+
+    struct Scope
+    {
+        std::unordered_map<NameId, Binding> bindings;
+
+        ScopeLayout& layout;
+
+        // Function nesting level the scope belongs to; 0 is the top level
+        size_t function;
+    };
+
+    GlobalEnvironment& globals;
+
+    Ast* ast = nullptr;
+
+    Pass pass = Pass::FindCaptures;
+
+    // Whether the statement being resolved is the body of an if or loop rather than of a block
+    bool conditional = false;
+
+    // Innermost scope last; empty at the top level
+    std::vector<Scope> scopes;
+
+    struct Function
+    {
+        uint32_t             frameSize = 0;
+        std::vector<Capture> captures;
+    };
+
+    // Functions being resolved, innermost last; the first entry is the top level
+    std::vector<Function> functions = {Function()};
+
+    void beginScope(ScopeLayout& layout);
+    void endScope();
+
+    // Declares `name` in the innermost scope; redeclaring a name reuses its slot
+    VariableLocation declare(NameId name);
+
+    // Slot of `name` in the innermost scope, added on first use
+    Binding& bind(NameId name);
+
+    // Resolves `name` from the scopes below `depth`, all of them by default
+    VariableLocation lookup(NameId name, size_t depth);
+    VariableLocation lookup(NameId name) { return lookup(name, scopes.size()); }
+
+    // Resolves a statement that is the body of an if or loop
+    void resolveBranch(StatementId statement);
+
+    VariableLocation local(const Scope& scope, uint32_t slot) const;
+
+    // Index of the capture through which `function` reaches the local at `frameIndex` of an
+    // enclosing function, adding it (and any captures needed in between) on first use
+    uint32_t capture(size_t function, size_t declaringFunction, uint32_t frameIndex);
+};
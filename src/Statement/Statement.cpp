@@ -0,0 +1,11 @@
+#include "Statement.h"
+
+#include "../Ast/Ast.h"
+
+FunctionDefinitionStatement::FunctionDefinitionStatement(const Ast&     ast,
+                                                         NameId         name,
+                                                         IdList<NameId> parameters,
+                                                         StatementId    body)
+    : name(name), parameters(parameters), prototype(ast.getString(name), parameters.size, body)
+{
+}
@@ -1,224 +1,218 @@
 #pragma once
-#include <memory>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
+#include "../Ast/NodeId.h"
 #include "../Environment/Environment.h"
-#include "../Expression/Expression.h"
-#include "StatementVisitor.h"
+#include "../Function/FunctionPrototype.h"
 
-// Base class for statements
-class Statement
+class Ast;
+
+// Concrete type of a statement node, see ExpressionKind
+enum class StatementKind : uint8_t
 {
-   public:
-    virtual ~Statement() = default;
+    Expression,
+    Print,
+    Variable,
+    Block,
+    If,
+    While,
+    For,
+    FunctionDefinition,
+    Return
+};
 
-    // Accept method for visitor pattern
-    virtual void accept(StatementVisitor& visitor, Environment* env = nullptr) const = 0;
+// Base of the statement nodes, stored in an Ast like expressions, see ExpressionNode
+template <StatementKind Kind>
+struct StatementNode
+{
+    using Id = StatementId;
+
+    static constexpr StatementKind kind = Kind;
 };
 
-class ExpressionStatement : public Statement
+class ExpressionStatement : public StatementNode<StatementKind::Expression>
 {
    public:
-    ExpressionStatement(std::unique_ptr<Expression> expression, bool print)
-        : expression(std::move(expression)), print(print)
-    {
-    }
-
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
+    ExpressionStatement(ExpressionId expression, bool print) : expression(expression), print(print)
     {
-        return visitor.visitExpressionStatement(*this, env);
     }
 
-    const Expression* getExpression() const { return expression.get(); }
+    ExpressionId getExpression() const { return expression; }
 
     bool toPrint() const { return print; }
 
    private:
-    const std::unique_ptr<Expression> expression;
+    ExpressionId expression;
 
     bool print;
 };
 
-class PrintStatement : public Statement
+class PrintStatement : public StatementNode<StatementKind::Print>
 {
    public:
-    explicit PrintStatement(std::unique_ptr<Expression> expression)
-        : expression(std::move(expression))
-    {
-    }
+    explicit PrintStatement(ExpressionId expression) : expression(expression) {}
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitPrintStatement(*this, env);
-    }
-
-    const Expression* getExpression() const { return expression.get(); }
+    ExpressionId getExpression() const { return expression; }
 
    private:
-    const std::unique_ptr<Expression> expression;
+    ExpressionId expression;
 };
 
-class VariableStatement : public Statement
+class VariableStatement : public StatementNode<StatementKind::Variable>
 {
    public:
-    VariableStatement(const std::string& name, std::unique_ptr<Expression> initializer)
-        : name(name), initializer(std::move(initializer))
+    VariableStatement(NameId name, ExpressionId initializer) : name(name), initializer(initializer)
     {
     }
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitVariableStatement(*this, env);
-    }
+    NameId       getName() const { return name; }
+    ExpressionId getInitializer() const { return initializer; }
 
-    const std::string& getName() const { return name; }
-    const Expression*  getInitializer() const { return initializer.get(); }
+    // Set by the Resolver before the statement is executed
+    const VariableLocation& getLocation() const { return location; }
+    void                    resolve(const VariableLocation& resolved) const { location = resolved; }
 
    private:
-    const std::string name;
+    NameId name;
 
-    const std::unique_ptr<Expression> initializer;
+    ExpressionId initializer;
+
+    mutable VariableLocation location;
 };
 
-class BlockStatement : public Statement
+class BlockStatement : public StatementNode<StatementKind::Block>
 {
    public:
-    explicit BlockStatement(std::vector<std::unique_ptr<Statement>> statements)
-        : statements(std::move(statements))
-    {
-    }
+    explicit BlockStatement(IdList<StatementId> statements) : statements(statements) {}
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitBlockStatement(*this, env);
-    }
+    IdList<StatementId> getStatements() const { return statements; }
 
-    const std::vector<std::unique_ptr<Statement>>& getStatements() const { return statements; }
+    // Layout of the block's scope, set by the Resolver
+    const ScopeLayout& getScope() const { return scope; }
+    ScopeLayout&       getMutableScope() const { return scope; }
 
    private:
-    const std::vector<std::unique_ptr<Statement>> statements;
+    IdList<StatementId> statements;
+
+    mutable ScopeLayout scope;
 };
 
-class IfStatement : public Statement
+class IfStatement : public StatementNode<StatementKind::If>
 {
    public:
-    IfStatement(std::unique_ptr<Expression> condition,
-                std::unique_ptr<Statement>  thenBranch,
-                std::unique_ptr<Statement>  elseBranch)
-        : condition(std::move(condition)),
-          thenBranch(std::move(thenBranch)),
-          elseBranch(std::move(elseBranch))
+    IfStatement(ExpressionId condition, StatementId thenBranch, StatementId elseBranch)
+        : condition(condition), thenBranch(thenBranch), elseBranch(elseBranch)
     {
     }
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitIfStatement(*this, env);
-    }
-
-    const Expression* getCondition() const { return condition.get(); }
-    const Statement*  getThenBranch() const { return thenBranch.get(); }
-    const Statement*  getElseBranch() const { return elseBranch.get(); }
+    ExpressionId getCondition() const { return condition; }
+    StatementId  getThenBranch() const { return thenBranch; }
+    StatementId  getElseBranch() const { return elseBranch; }
 
    private:
-    const std::unique_ptr<Expression> condition;
-    const std::unique_ptr<Statement>  thenBranch;
-    const std::unique_ptr<Statement>  elseBranch;
+    ExpressionId condition;
+    StatementId  thenBranch;
+    StatementId  elseBranch;
 };
 
-class WhileStatement : public Statement
+class WhileStatement : public StatementNode<StatementKind::While>
 {
    public:
-    WhileStatement(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body)
-        : condition(std::move(condition)), body(std::move(body))
-    {
-    }
-
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitWhileStatement(*this, env);
-    }
+    WhileStatement(ExpressionId condition, StatementId body) : condition(condition), body(body) {}
 
-    const Expression* getCondition() const { return condition.get(); }
-    const Statement*  getBody() const { return body.get(); }
+    ExpressionId getCondition() const { return condition; }
+    StatementId  getBody() const { return body; }
 
    private:
-    const std::unique_ptr<Expression> condition;
-    const std::unique_ptr<Statement>  body;
+    ExpressionId condition;
+    StatementId  body;
 };
 
-class ForStatement : public Statement
+class ForStatement : public StatementNode<StatementKind::For>
 {
    public:
-    ForStatement(std::unique_ptr<Statement>  initializer,
-                 std::unique_ptr<Expression> condition,
-                 std::unique_ptr<Expression> increment,
-                 std::unique_ptr<Statement>  body)
-        : initializer(std::move(initializer)),
-          condition(std::move(condition)),
-          increment(std::move(increment)),
-          body(std::move(body))
+    ForStatement(StatementId  initializer,
+                 ExpressionId condition,
+                 ExpressionId increment,
+                 StatementId  body)
+        : initializer(initializer), condition(condition), increment(increment), body(body)
     {
     }
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitForStatement(*this, env);
-    }
-
-    const Statement*  getInitializer() const { return initializer.get(); }
-    const Expression* getCondition() const { return condition.get(); }
-    const Expression* getIncrement() const { return increment.get(); }
-    const Statement*  getBody() const { return body.get(); }
+    StatementId  getInitializer() const { return initializer; }
+    ExpressionId getCondition() const { return condition; }
+    ExpressionId getIncrement() const { return increment; }
+    StatementId  getBody() const { return body; }
 
    private:
-    const std::unique_ptr<Statement>  initializer;
-    const std::unique_ptr<Expression> condition;
-    const std::unique_ptr<Expression> increment;
-    const std::unique_ptr<Statement>  body;
+    StatementId  initializer;
+    ExpressionId condition;
+    ExpressionId increment;
+    StatementId  body;
 };
 
-class FunctionDefinitionStatement : public Statement
+class FunctionDefinitionStatement : public StatementNode<StatementKind::FunctionDefinition>
 {
    public:
-    FunctionDefinitionStatement(const std::string&              name,
-                                std::vector<std::string>        parameters,
-                                std::shared_ptr<BlockStatement> body)
-        : name(name), parameters(std::move(parameters)), body(std::move(body))
-    {
-    }
+    // `body` is a block
+    FunctionDefinitionStatement(const Ast&     ast,
+                                NameId         name,
+                                IdList<NameId> parameters,
+                                StatementId    body);
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitFunctionDefinitionStatement(*this, env);
-    }
+    NameId getName() const { return name; }
 
-    const std::string& getName() const { return name; }
+    IdList<NameId> getParameters() const { return parameters; }
 
-    const std::vector<std::string>& getParameters() const { return parameters; }
+    StatementId getBody() const { return prototype.body; }
 
-    const std::shared_ptr<BlockStatement> getBody() const { return body; }
+    // Shared by every closure of the function
+    const FunctionPrototype& getPrototype() const { return prototype; }
 
-   private:
-    const std::string name;
+    // Set by the Resolver: where the function's name is defined, and the frame layout of the
+    // prototype
+    const VariableLocation&      getLocation() const { return location; }
+    const ScopeLayout&           getParameterScope() const { return prototype.parameterScope; }
+    const std::vector<uint32_t>& getParameterSlots() const { return prototype.parameterSlots; }
+    uint32_t                     getFrameSize() const { return prototype.frameSize; }
+    const std::vector<Capture>&  getCaptures() const { return prototype.captures; }
 
-    const std::vector<std::string> parameters;
+    ScopeLayout& getMutableParameterScope() const { return prototype.parameterScope; }
+
+    void resolve(const VariableLocation& resolved,
+                 std::vector<uint32_t>   slots,
+                 uint32_t                size,
+                 std::vector<Capture>    captured) const
+    {
+        location                 = resolved;
+        prototype.parameterSlots = std::move(slots);
+        prototype.frameSize      = size;
+        prototype.captures       = std::move(captured);
+    }
 
-    const std::shared_ptr<BlockStatement> body;
+   private:
+    NameId         name;
+    IdList<NameId> parameters;
+
+    mutable VariableLocation  location;
+    mutable FunctionPrototype prototype;
 };
 
-class ReturnStatement : public Statement
+class ReturnStatement : public StatementNode<StatementKind::Return>
 {
    public:
-    explicit ReturnStatement(std::unique_ptr<Expression> expr) : expression(std::move(expr)) {}
+    explicit ReturnStatement(ExpressionId expression) : expression(expression) {}
 
-    void accept(StatementVisitor& visitor, Environment* env = nullptr) const override
-    {
-        visitor.visitReturnStatement(*this, env);
-    }
+    ExpressionId getExpression() const { return expression; }
 
-    const Expression* getExpression() const { return expression.get(); }
+    // Set by the Resolver when the returned expression is a call made from inside a function
+    bool isTailCall() const { return tailCall; }
+    void markTailCall() const { tailCall = true; }
 
    private:
-    std::unique_ptr<Expression> expression;
+    ExpressionId expression;
+
+    mutable bool tailCall = false;
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "../Environment/Environment.h"
 
 // Forward Declarations
@@ -13,6 +15,18 @@ class ForStatement;
 class FunctionDefinitionStatement;
 class ReturnStatement;
 
+// How a statement finished executing. Anything other than Normal stops the enclosing statements
+// until it reaches the construct that handles it, e.g. a function call for Return. TailCall is a
+// `return f(...)` whose call is left for the returning function to make in place of its own frame.
+enum class Completion : uint8_t
+{
+    Normal,
+    Return,
+    TailCall
+};
+
+// Like ExpressionVisitor, templated on the result of each visit method
+template <typename R>
 class StatementVisitor
 {
    public:
@@ -20,14 +34,14 @@ class StatementVisitor
 
     // clang-format off
     // Visit methods for different kinds of statements
-    virtual void visitPrintStatement(const PrintStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitExpressionStatement(const ExpressionStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitVariableStatement(const VariableStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitBlockStatement(const BlockStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitIfStatement(const IfStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitWhileStatement(const WhileStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitForStatement(const ForStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env = nullptr) = 0;
-    virtual void visitReturnStatement(const ReturnStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitPrintStatement(const PrintStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitExpressionStatement(const ExpressionStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitVariableStatement(const VariableStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitBlockStatement(const BlockStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitIfStatement(const IfStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitWhileStatement(const WhileStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitForStatement(const ForStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env = nullptr) = 0;
+    virtual R visitReturnStatement(const ReturnStatement& statement, Environment* env = nullptr) = 0;
     // clang-format on
 };
@@ -0,0 +1,21 @@
+# Writes the source file defining transpilerRuntime, the text every translated program starts
+# with: the runtime and the interpreter headers it includes, in order, with their `#pragma once`
+# and local `#include` lines removed so the text stands alone.
+#
+# Usage: cmake -DSOURCES=<header>,<header>... -DHEADER=<Transpiler.h> -DOUTPUT=<file.cpp>
+#              -P EmbedRuntime.cmake
+
+string(REPLACE "," ";" sources "${SOURCES}")
+
+set(runtime "")
+foreach(source ${sources})
+    file(READ ${source} text)
+    string(REGEX REPLACE "#pragma once\n" "" text "${text}")
+    string(REGEX REPLACE "#include \"[^\"]*\"\n" "" text "${text}")
+    string(APPEND runtime "${text}\n")
+endforeach()
+
+file(WRITE ${OUTPUT}
+     "// Generated by EmbedRuntime.cmake from the runtime's headers, do not edit\n"
+     "#include \"${HEADER}\"\n\n"
+     "const char* const transpilerRuntime = R\"runtime(\n${runtime})runtime\";\n")
@@ -0,0 +1,3 @@
+// The runtime is only ever used as text, by the programs the compile command writes. Compiling it
+// here checks it, with warnings enabled, whenever the interpreter is built.
+#include "Runtime.h"
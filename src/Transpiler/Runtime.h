@@ -0,0 +1,583 @@
+#pragma once
+
+// Runtime of a Lox program translated to C++ by `interpreter compile`. Values, calls and globals
+// are its own, while operators and number printing come from the interpreter's own headers, so
+// they behave exactly as in the interpreter.
+//
+// Every translated program starts with this file, the headers it includes from the interpreter
+// and nothing else, so it can be built without this repository: the build embeds them as the
+// string transpilerRuntime, see EmbedRuntime.cmake. It is also compiled with the interpreter, by
+// Runtime.cpp, so it is checked like the rest of the code.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Operators/OperatorDefinitions.h"
+#include "../Value/NumberPrinting.h"
+
+namespace lox
+{
+
+// Reported as "Runtime Error: ..." with exit code 70
+struct RuntimeError : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+class Object
+{
+   public:
+    virtual ~Object() = default;
+
+    void retain() { ++refCount; }
+    void release()
+    {
+        if (--refCount == 0)
+        {
+            delete this;
+        }
+    }
+
+   private:
+    uint32_t refCount = 0;
+};
+
+class Value
+{
+   public:
+    enum class Type : uint8_t
+    {
+        Nil,
+        Undefined,  // a local whose declaration has not run yet; programs never see it
+        Bool,
+        Number,
+        String,
+        Function,
+        Cell
+    };
+
+    Value() : type(Type::Nil), number(0) {}
+    Value(bool value) : type(Type::Bool), boolean(value) {}
+    Value(double value) : type(Type::Number), number(value) {}
+    Value(Type type, Object* object) : type(type), object(object) { object->retain(); }
+
+    Value(const Value& other) : type(other.type), number(other.number)
+    {
+        if (isObject()) object->retain();
+    }
+    Value(Value&& other) noexcept : type(other.type), number(other.number)
+    {
+        other.type = Type::Nil;
+    }
+    Value& operator=(Value other) noexcept
+    {
+        std::swap(type, other.type);
+        std::swap(number, other.number);
+        return *this;
+    }
+    ~Value()
+    {
+        if (isObject()) object->release();
+    }
+
+    static Value undefined()
+    {
+        Value value;
+        value.type = Type::Undefined;
+        return value;
+    }
+
+    Type getType() const { return type; }
+    bool isObject() const { return type >= Type::String; }
+    bool isUndefined() const { return type == Type::Undefined; }
+
+    bool    asBool() const { return boolean; }
+    double  asNumber() const { return number; }
+    Object* asObject() const { return object; }
+
+   private:
+    Type type;
+    union
+    {
+        bool    boolean;
+        double  number;
+        Object* object;
+    };
+};
+
+class String : public Object
+{
+   public:
+    explicit String(std::string value) : value(std::move(value)) {}
+
+    const std::string value;
+};
+
+inline Value string(std::string value)
+{
+    return Value(Value::Type::String, new String(std::move(value)));
+}
+
+inline const std::string& asString(const Value& value)
+{
+    return static_cast<String*>(value.asObject())->value;
+}
+
+class Function : public Object
+{
+   public:
+    explicit Function(int arity) : arity(arity) {}
+
+    virtual Value call(Value* arguments) const = 0;
+    virtual void  print() const               = 0;
+
+    const int arity;
+};
+
+inline const Function& asFunction(const Value& value)
+{
+    return *static_cast<Function*>(value.asObject());
+}
+
+// Holds a captured variable, shared by the frame that declares it and the closures capturing it
+class Cell : public Object
+{
+   public:
+    explicit Cell(Value value) : value(std::move(value)) {}
+
+    Value value;
+};
+
+inline Value box(Value value)
+{
+    return Value(Value::Type::Cell, new Cell(std::move(value)));
+}
+
+inline Cell& cellOf(const Value& slot)
+{
+    return *static_cast<Cell*>(slot.asObject());
+}
+
+// Cell of a captured local, created if its declaration has not run yet
+inline Cell& cellIn(Value& slot)
+{
+    if (slot.isUndefined())
+    {
+        slot = box(Value::undefined());
+    }
+    return cellOf(slot);
+}
+
+// A local whose declaration a branch or loop may skip: while it is undefined, the variable its name
+// referred to before
+template <typename F>
+Value orFallback(const Value& local, F fallback)
+{
+    return local.isUndefined() ? fallback() : local;
+}
+
+// A local captured by a closure being created: its slot, holding its Cell
+inline const Value& capture(Value& slot)
+{
+    cellIn(slot);
+    return slot;
+}
+
+// A function defined in Lox: the translated code and the cells it captured
+class Closure : public Function
+{
+   public:
+    using Code = Value (*)(const Closure& closure, Value* arguments);
+
+    Closure(const char* name, int arity, Code code, std::vector<Value> captures)
+        : Function(arity), name(name), code(code), captures(std::move(captures))
+    {
+    }
+
+    Value call(Value* arguments) const override { return code(*this, arguments); }
+    void  print() const override { std::cout << "<fn " << name << ">" << std::endl; }
+
+    const char* const        name;
+    const Code               code;
+    const std::vector<Value> captures;
+};
+
+inline Value closure(const char* name, int arity, Closure::Code code, std::vector<Value> captures)
+{
+    return Value(Value::Type::Function, new Closure(name, arity, code, std::move(captures)));
+}
+
+class Clock : public Function
+{
+   public:
+    Clock() : Function(0) {}
+
+    Value call(Value*) const override
+    {
+        using namespace std::chrono;
+        auto secondsSinceEpoch =
+            duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+        return Value(static_cast<double>(secondsSinceEpoch));
+    }
+    void print() const override { std::cout << std::endl; }
+};
+
+// Value of the native function `name`
+inline Value native(const std::string& name)
+{
+    if (name == "clock")
+    {
+        return Value(Value::Type::Function, new Clock());
+    }
+    return Value();
+}
+
+class Global
+{
+   public:
+    explicit Global(const char* name) : name(name) {}
+    Global(const char* name, Value value) : name(name), value(std::move(value)), defined(true) {}
+
+    void define(Value defining)
+    {
+        value   = std::move(defining);
+        defined = true;
+    }
+
+    const Value& get() const
+    {
+        if (!defined) undefined();
+        return value;
+    }
+
+    const Value& assign(Value assigned)
+    {
+        if (!defined) undefined();
+        value = std::move(assigned);
+        return value;
+    }
+
+   private:
+    const char* name;
+    Value       value;
+    bool        defined = false;
+
+    [[noreturn]] void undefined() const
+    {
+        std::cerr << "Undefined variable '" << name << "'." << std::endl;
+        std::exit(70);
+    }
+};
+
+// Truthiness: nil and false are falsy, and so are zero and functions; strings are truthy
+inline bool truthy(double value)
+{
+    return value != 0;
+}
+
+inline bool truthy(bool value)
+{
+    return value;
+}
+
+inline bool truthy(const Value& value)
+{
+    switch (value.getType())
+    {
+        case Value::Type::Bool:
+            return value.asBool();
+        case Value::Type::Number:
+            return value.asNumber() != 0;
+        case Value::Type::String:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline void print(double value)
+{
+    printNumber(value);
+}
+
+inline void print(bool value)
+{
+    std::cout << (value ? "true" : "false") << std::endl;
+}
+
+inline void print(const Value& value)
+{
+    switch (value.getType())
+    {
+        case Value::Type::Nil:
+            std::cout << "nil" << std::endl;
+            break;
+        case Value::Type::Bool:
+            print(value.asBool());
+            break;
+        case Value::Type::Number:
+            print(value.asNumber());
+            break;
+        case Value::Type::String:
+            std::cout << asString(value) << std::endl;
+            break;
+        default:
+            asFunction(value).print();
+            break;
+    }
+}
+
+// Operators
+
+// Type of the result of `op` on values of any type. Only `+` can make more than one type.
+template <BinaryOperator op>
+using ResultOf = std::conditional_t<op == BinaryOperator::Add,
+                                    Value,
+                                    std::conditional_t<Operators::isArithmetic(op), double, bool>>;
+
+template <BinaryOperator op>
+[[noreturn]] void unsupported(const char* operandKind)
+{
+    throw RuntimeError(Operators::unsupportedOperands(op, operandKind));
+}
+
+template <BinaryOperator op>
+ResultOf<op> values(const Value& lhs, const Value& rhs)
+{
+    const auto left  = lhs.getType();
+    const auto right = rhs.getType();
+    if (left == Value::Type::Number && right == Value::Type::Number)
+    {
+        return Operators::numbers<op>(lhs.asNumber(), rhs.asNumber());
+    }
+    if (left == Value::Type::String && right == Value::Type::String)
+    {
+        if constexpr (op == BinaryOperator::Add) return string(asString(lhs) + asString(rhs));
+        else if constexpr (op == BinaryOperator::Equal) return asString(lhs) == asString(rhs);
+        else if constexpr (op == BinaryOperator::NotEqual) return asString(lhs) != asString(rhs);
+        else unsupported<op>("strings");
+    }
+    if (left == Value::Type::Bool && right == Value::Type::Bool)
+    {
+        if constexpr (op == BinaryOperator::Equal) return lhs.asBool() == rhs.asBool();
+        else if constexpr (op == BinaryOperator::NotEqual) return lhs.asBool() != rhs.asBool();
+        else unsupported<op>("booleans");
+    }
+
+    // Any other pairing, including nil with nil and functions, is never equal
+    if constexpr (Operators::isEquality(op))
+    {
+        return op == BinaryOperator::NotEqual;
+    }
+    else
+    {
+        throw RuntimeError(Operators::incompatibleOperands(op));
+    }
+}
+
+// Operands evaluated in order, for an operator whose operands have effects. Braced initialization
+// is sequenced left to right, unlike function arguments.
+template <typename L, typename R>
+struct Operands
+{
+    L left;
+    R right;
+};
+
+template <typename L, typename R>
+Operands(L, R) -> Operands<L, R>;
+
+// `op` on operands of static types double, bool or Value. Two numbers, or two bools compared for
+// equality, need no dispatch.
+template <BinaryOperator op, typename L, typename R>
+auto binary(const L& lhs, const R& rhs)
+{
+    if constexpr (std::is_same_v<L, double> && std::is_same_v<R, double>)
+    {
+        return Operators::numbers<op>(lhs, rhs);
+    }
+    else if constexpr (std::is_same_v<L, bool> && std::is_same_v<R, bool> &&
+                       Operators::isEquality(op))
+    {
+        return op == BinaryOperator::Equal ? lhs == rhs : lhs != rhs;
+    }
+    else if constexpr (std::is_same_v<L, Value> && std::is_same_v<R, Value>)
+    {
+        return values<op>(lhs, rhs);
+    }
+    else
+    {
+        return values<op>(Value(lhs), Value(rhs));
+    }
+}
+
+template <BinaryOperator op, typename L, typename R>
+auto binary(const Operands<L, R>& operands)
+{
+    return binary<op>(operands.left, operands.right);
+}
+
+inline double negate(const Value& operand)
+{
+    if (operand.getType() != Value::Type::Number)
+    {
+        throw RuntimeError(Operators::negateOperandError);
+    }
+    return -operand.asNumber();
+}
+
+inline bool logicalNot(const Value& operand)
+{
+    switch (operand.getType())
+    {
+        case Value::Type::Bool:
+            return !operand.asBool();
+        case Value::Type::Number:
+            return operand.asNumber() == 0;
+        case Value::Type::Nil:
+            return true;
+        default:
+            throw RuntimeError(Operators::notOperandError);
+    }
+}
+
+// `and` and `or` produce one of their operands. The right one is only evaluated if needed.
+template <typename L, typename F>
+auto logicalAnd(const L& left, F right)
+{
+    using R = decltype(right());
+    if constexpr (std::is_same_v<L, R>)
+    {
+        return truthy(left) ? right() : left;
+    }
+    else
+    {
+        return truthy(left) ? Value(right()) : Value(left);
+    }
+}
+
+template <typename L, typename F>
+auto logicalOr(const L& left, F right)
+{
+    using R = decltype(right());
+    if constexpr (std::is_same_v<L, R>)
+    {
+        return truthy(left) ? left : right();
+    }
+    else
+    {
+        return truthy(left) ? Value(left) : Value(right());
+    }
+}
+
+// Calls
+
+// A tail call waiting to run in place of the function that made it
+struct PendingCall
+{
+    bool               pending = false;
+    Value              callee;
+    std::vector<Value> arguments;
+};
+
+inline PendingCall pendingCall;
+
+// Runs `function`, then any tail calls it leaves pending, so tail calls take no native stack
+inline Value invoke(const Function& function, Value* arguments)
+{
+    Value result = function.call(arguments);
+    while (pendingCall.pending)
+    {
+        pendingCall.pending      = false;
+        Value              next  = std::move(pendingCall.callee);
+        std::vector<Value> taken = std::move(pendingCall.arguments);
+        result                   = asFunction(next).call(taken.data());
+    }
+    return result;
+}
+
+// An evaluated callee, checked before its arguments are evaluated
+class Callee
+{
+   public:
+    explicit Callee(Value value) : value(std::move(value))
+    {
+        if (this->value.getType() != Value::Type::Function)
+        {
+            throw RuntimeError("Attempt to call a non-function object");
+        }
+    }
+
+    Value call() { return call(nullptr, 0); }
+
+    template <size_t N>
+    Value call(Value (&&arguments)[N])
+    {
+        return call(arguments, N);
+    }
+
+    Value tailCall() { return tailCall(nullptr, 0); }
+
+    template <size_t N>
+    Value tailCall(Value (&&arguments)[N])
+    {
+        return tailCall(arguments, N);
+    }
+
+   private:
+    Value value;
+
+    const Function& check(size_t count) const
+    {
+        const Function& function = asFunction(value);
+        if (static_cast<size_t>(function.arity) != count)
+        {
+            throw RuntimeError("Incorrect number of arguments to function.");
+        }
+        return function;
+    }
+
+    Value call(Value* arguments, size_t count) { return invoke(check(count), arguments); }
+
+    // Leaves a call of a Lox function pending for the caller's invoke; native functions are called
+    // directly
+    Value tailCall(Value* arguments, size_t count)
+    {
+        const Function& function = check(count);
+        if (!dynamic_cast<const Closure*>(&function))
+        {
+            return function.call(arguments);
+        }
+        pendingCall.arguments.assign(std::make_move_iterator(arguments),
+                                     std::make_move_iterator(arguments + count));
+        pendingCall.callee  = std::move(value);
+        pendingCall.pending = true;
+        return Value();
+    }
+};
+
+// Runs the translated script, reporting runtime errors as the interpreter does
+inline int run(void (*script)())
+{
+    std::cout << std::unitbuf;
+    std::cerr << std::unitbuf;
+    try
+    {
+        script();
+    }
+    catch (const RuntimeError& e)
+    {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 70;
+    }
+    return 0;
+}
+
+}  // namespace lox
@@ -0,0 +1,564 @@
+#include "Transpiler.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+#include "../Expression/Expression.h"
+#include "../Operators/Operators.h"
+
+namespace
+{
+
+// Names of the BinaryOperator enumerators, which the runtime shares, in order
+constexpr std::array<const char*, 10> operatorNames = {"Add",
+                                                       "Subtract",
+                                                       "Multiply",
+                                                       "Divide",
+                                                       "Equal",
+                                                       "NotEqual",
+                                                       "Greater",
+                                                       "GreaterEqual",
+                                                       "Less",
+                                                       "LessEqual"};
+
+// A double literal that reads back as exactly `value`
+std::string numberLiteral(double value)
+{
+    // A literal too large for a double, or a folded operation on one, has no digits to print
+    if (std::isinf(value))
+    {
+        return value < 0 ? "(-HUGE_VAL)" : "HUGE_VAL";
+    }
+    if (std::isnan(value))
+    {
+        return std::signbit(value) ? "(-NAN)" : "NAN";
+    }
+
+    std::ostringstream out;
+    out.precision(17);
+    out << value;
+    std::string text = out.str();
+    if (text.find_first_of(".e") == std::string::npos)
+    {
+        text += ".0";
+    }
+    return text;
+}
+
+std::string stringLiteral(const std::string& value)
+{
+    std::string text = "\"";
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            text += '\\';
+            text += c;
+        }
+        else if (c == '\n')
+        {
+            text += "\\n";
+        }
+        else if (c < ' ' || c > '~')
+        {
+            // Octal escapes take at most three digits, unlike hexadecimal ones
+            char escape[5];
+            std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+            text += escape;
+        }
+        else
+        {
+            text += c;
+        }
+    }
+    return text + "\"";
+}
+
+}  // namespace
+
+std::string Transpiler::transpile(const Ast&               tree,
+                                  const GlobalEnvironment& globals,
+                                  uint32_t                 frameSize)
+{
+    ast                      = &tree;
+    inFunction               = false;
+    const std::string script = frame(frameSize, "", tree.getStatements());
+
+    std::string out = "// Generated by `interpreter compile`. Build with a C++20 compiler, e.g.\n"
+                      "// g++ -std=c++20 -O2\n\n";
+    out += transpilerRuntime;
+    out += "\nnamespace\n{\n\nlox::Global globals[] = {\n";
+    for (uint32_t index = 0; index < globals.size(); ++index)
+    {
+        // Only natives are defined before the program runs
+        const std::string name = stringLiteral(globals.getName(index));
+        out += globals.isDefined(index)
+                   ? "    lox::Global(" + name + ", lox::native(" + name + ")),\n"
+                   : "    lox::Global(" + name + "),\n";
+    }
+    out += "};\n\n";
+
+    for (size_t index = 0; index < strings.size(); ++index)
+    {
+        out += "const lox::Value k" + std::to_string(index) + " = lox::string(" +
+               stringLiteral(strings[index]) + ");\n";
+    }
+    out += "\n";
+
+    for (const auto& declaration : declarations)
+    {
+        out += declaration + "\n";
+    }
+    for (const auto& function : functions)
+    {
+        out += "\n" + function;
+    }
+
+    out += "\nvoid script()\n{\n" + script + "}\n\n}  // namespace\n\n";
+    out += "int main()\n{\n    return lox::run(script);\n}\n";
+    return out;
+}
+
+std::string Transpiler::frame(uint32_t                     frameSize,
+                              const std::string&           prologue,
+                              std::span<const StatementId> statements)
+{
+    body        = "";
+    indentation = 1;
+
+    if (frameSize > 0)
+    {
+        std::string slots;
+        for (uint32_t index = 0; index < frameSize; ++index)
+        {
+            slots += (index ? ", " : "") + slot(index) + " = lox::Value::undefined()";
+        }
+        line("lox::Value " + slots + ";");
+    }
+    body += prologue;
+
+    for (StatementId statement : statements)
+    {
+        visit(*this, *ast, statement);
+    }
+    return body;
+}
+
+void Transpiler::line(const std::string& text)
+{
+    body += std::string(4 * indentation, ' ') + text + "\n";
+}
+
+Transpiler::Code Transpiler::translate(ExpressionId expr)
+{
+    visit(*this, *ast, expr);
+    return std::move(expression);
+}
+
+std::string Transpiler::condition(const Code& code)
+{
+    return code.type == StaticType::Bool ? code.text : "lox::truthy(" + code.text + ")";
+}
+
+std::string Transpiler::store(const VariableLocation& location, const std::string& value) const
+{
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            return "globals[" + std::to_string(location.index) + "].define(" + value + ")";
+        case VariableLocation::Kind::Frame:
+            return slot(location.index) + " = " + value;
+        case VariableLocation::Kind::Cell:
+            return "lox::cellIn(" + slot(location.index) + ").value = " + value;
+        default:
+            return "lox::cellOf(closure.captures[" + std::to_string(location.index) +
+                   "]).value = " + value;
+    }
+}
+
+std::string Transpiler::load(const VariableLocation& location) const
+{
+    std::string local;
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            return "globals[" + std::to_string(location.index) + "].get()";
+        case VariableLocation::Kind::Frame:
+            local = slot(location.index);
+            break;
+        case VariableLocation::Kind::Cell:
+            local = "lox::cellIn(" + slot(location.index) + ").value";
+            break;
+        default:
+            local = "lox::cellOf(closure.captures[" + std::to_string(location.index) + "]).value";
+            break;
+    }
+    if (!location.fallback)
+    {
+        return local;
+    }
+    return "lox::orFallback(" + local + ", [&] { return " + load(*location.fallback) + "; })";
+}
+
+std::string Transpiler::assign(const VariableLocation& location, const std::string& value) const
+{
+    // The value cannot declare the local, so the target is picked before it is evaluated
+    if (location.fallback)
+    {
+        VariableLocation local = location;
+        local.fallback         = nullptr;
+        return "(" + load(local) + ".isUndefined() ? " + assign(*location.fallback, value) +
+               " : " + assign(local, value) + ")";
+    }
+    if (location.kind == VariableLocation::Kind::Global)
+    {
+        return "globals[" + std::to_string(location.index) + "].assign(" + value + ")";
+    }
+
+    // The right-hand side of a C++ assignment is evaluated first, as in the Evaluator
+    return "(" + store(location, value) + ")";
+}
+
+void Transpiler::visitPrintStatement(const PrintStatement& statement, Environment*)
+{
+    line("lox::print(" + translate(statement.getExpression()).text + ");");
+}
+
+void Transpiler::visitExpressionStatement(const ExpressionStatement& statement, Environment*)
+{
+    const Code code = translate(statement.getExpression());
+    if (statement.toPrint())
+    {
+        line("lox::print(" + code.text + ");");
+    }
+    else if (!code.pure)
+    {
+        line(code.text + ";");
+    }
+}
+
+void Transpiler::visitVariableStatement(const VariableStatement& statement, Environment*)
+{
+    const std::string value =
+        statement.getInitializer() ? translate(statement.getInitializer()).text : "lox::Value()";
+    line(store(statement.getLocation(), value) + ";");
+}
+
+void Transpiler::visitBlockStatement(const BlockStatement& statement, Environment*)
+{
+    line("{");
+    ++indentation;
+    for (StatementId stmnt : ast->get(statement.getStatements()))
+    {
+        visit(*this, *ast, stmnt);
+    }
+
+    // Release the block's locals, as the Evaluator does
+    const auto& scope = statement.getScope();
+    for (uint32_t index = 0; index < scope.slotCount; ++index)
+    {
+        line(slot(scope.frameOffset + index) + " = lox::Value::undefined();");
+    }
+    --indentation;
+    line("}");
+}
+
+void Transpiler::visitIfStatement(const IfStatement& statement, Environment*)
+{
+    line("if (" + condition(translate(statement.getCondition())) + ")");
+    nested(statement.getThenBranch());
+    if (statement.getElseBranch())
+    {
+        line("else");
+        nested(statement.getElseBranch());
+    }
+}
+
+void Transpiler::visitWhileStatement(const WhileStatement& statement, Environment*)
+{
+    line("while (" + condition(translate(statement.getCondition())) + ")");
+    nested(statement.getBody());
+}
+
+void Transpiler::visitForStatement(const ForStatement& statement, Environment*)
+{
+    if (statement.getInitializer())
+    {
+        visit(*this, *ast, statement.getInitializer());
+    }
+    const std::string test =
+        statement.getCondition() ? condition(translate(statement.getCondition())) : "";
+    const std::string increment =
+        statement.getIncrement() ? translate(statement.getIncrement()).text : "";
+    line("for (; " + test + "; " + increment + ")");
+    nested(statement.getBody());
+}
+
+void Transpiler::nested(StatementId statement)
+{
+    if (statement.kind() == StatementKind::Block)
+    {
+        visit(*this, *ast, statement);
+        return;
+    }
+    line("{");
+    ++indentation;
+    visit(*this, *ast, statement);
+    --indentation;
+    line("}");
+}
+
+void Transpiler::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
+                                                  Environment*)
+{
+    const std::string name =
+        "f" + std::to_string(++functionCount) + "_" + ast->getString(statement.getName());
+    const std::string signature = "lox::Value " + name +
+                                  "([[maybe_unused]] const lox::Closure& closure, "
+                                  "[[maybe_unused]] lox::Value* arguments)";
+
+    // Arguments move to their parameter slots, where a repeated name makes the last one win, and
+    // captured parameters are boxed
+    std::string prologue;
+    const auto& parameters = statement.getParameterSlots();
+    for (size_t index = 0; index < parameters.size(); ++index)
+    {
+        prologue += "    " + slot(parameters[index]) + " = std::move(arguments[" +
+                    std::to_string(index) + "]);\n";
+    }
+    const auto& parameterScope = statement.getParameterScope();
+    for (uint32_t index = 0; index < parameterScope.slotCount; ++index)
+    {
+        if (parameterScope.captured[index])
+        {
+            prologue += "    " + slot(index) + " = lox::box(std::move(" + slot(index) + "));\n";
+        }
+    }
+
+    const std::string enclosingBody        = std::move(body);
+    const int         enclosingIndentation = indentation;
+    const bool        enclosingInFunction  = inFunction;
+
+    inFunction = true;
+    const auto& block      = ast->get<BlockStatement>(statement.getBody());
+    const auto  statements = ast->get(block.getStatements());
+    std::string code       = frame(statement.getFrameSize(), prologue, statements);
+
+    // A body that does not end in a return falls off the end, returning nil
+    if (statements.empty() || statements.back().kind() != StatementKind::Return)
+    {
+        code += "    return lox::Value();\n";
+    }
+    functions.push_back(signature + "\n{\n" + code + "}\n");
+    declarations.push_back(signature + ";");
+
+    body        = enclosingBody;
+    indentation = enclosingIndentation;
+    inFunction  = enclosingInFunction;
+
+    std::string captures;
+    for (const auto& capture : statement.getCaptures())
+    {
+        captures += captures.empty() ? "" : ", ";
+        captures += capture.fromFrame
+                        ? "lox::capture(" + slot(capture.index) + ")"
+                        : "closure.captures[" + std::to_string(capture.index) + "]";
+    }
+    line(store(statement.getLocation(),
+               "lox::closure(" + stringLiteral(ast->getString(statement.getName())) + ", " +
+                   std::to_string(parameters.size()) + ", &" + name + ", {" + captures + "})") +
+         ";");
+}
+
+void Transpiler::visitReturnStatement(const ReturnStatement& statement, Environment*)
+{
+    const ExpressionId value = statement.getExpression();
+    if (!inFunction)
+    {
+        // A `return` outside any function ends the script
+        if (value)
+        {
+            line(translate(value).text + ";");
+        }
+        line("return;");
+        return;
+    }
+
+    if (statement.isTailCall())
+    {
+        const auto& call = ast->get<CallExpression>(value);
+        line("return lox::Callee(" + translate(call.getCallee()).text + ").tailCall(" +
+             arguments(call) + ");");
+        return;
+    }
+    line("return " + (value ? translate(value).text : "lox::Value()") + ";");
+}
+
+void Transpiler::visitLiteralExpression(const LiteralExpression& expr, Environment*)
+{
+    const Value& constant = expr.getConstant();
+    switch (expr.getType())
+    {
+        case LiteralType::Number:
+            expression = {numberLiteral(constant.asNumber()), StaticType::Number, true, true};
+            break;
+        case LiteralType::Boolean:
+            expression = {constant.asBool() ? "true" : "false", StaticType::Bool, true, true};
+            break;
+        case LiteralType::Nil:
+            expression = {"lox::Value()", StaticType::Value, true, true};
+            break;
+        case LiteralType::String:
+        {
+            auto [it, added] = stringIndices.emplace(&constant, strings.size());
+            if (added)
+            {
+                strings.push_back(constant.asString());
+            }
+            expression = {"k" + std::to_string(it->second), StaticType::Value, true, true};
+            break;
+        }
+    }
+}
+
+void Transpiler::visitUnaryExpression(const UnaryExpression& expr, Environment*)
+{
+    const Code operand = translate(expr.getRight());
+    if (expr.getOperator() == UnaryOperator::Negate)
+    {
+        if (operand.type == StaticType::Number)
+        {
+            expression = {"(-" + operand.text + ")", StaticType::Number, operand.pure,
+                          operand.constant};
+        }
+        else
+        {
+            expression = {"lox::negate(" + operand.text + ")", StaticType::Number};
+        }
+        return;
+    }
+
+    switch (operand.type)
+    {
+        case StaticType::Bool:
+            expression = {"(!" + operand.text + ")", StaticType::Bool, operand.pure,
+                          operand.constant};
+            break;
+        case StaticType::Number:
+            expression = {"(" + operand.text + " == 0)", StaticType::Bool, operand.pure,
+                          operand.constant};
+            break;
+        default:
+            expression = {"lox::logicalNot(" + operand.text + ")", StaticType::Bool};
+            break;
+    }
+}
+
+void Transpiler::visitBinaryExpression(const BinaryExpression& expr, Environment*)
+{
+    const Code left  = translate(expr.getLeft());
+    const Code right = translate(expr.getRight());
+    const auto op    = expr.getOperator();
+
+    // Function arguments and the operands of C++ operators are evaluated in no particular order,
+    // which only matters if one of them has an effect the other could observe
+    const bool anyOrder = (left.pure && right.pure) || left.constant || right.constant;
+    const bool pure     = left.pure && right.pure;
+    const bool constant = left.constant && right.constant;
+
+    if (anyOrder && left.type == StaticType::Number && right.type == StaticType::Number &&
+        op != BinaryOperator::Divide)
+    {
+        const auto type = Operators::isArithmetic(op) ? StaticType::Number : StaticType::Bool;
+        expression = {"(" + left.text + " " + Operators::toLexeme(op) + " " + right.text + ")",
+                      type, pure, constant};
+        return;
+    }
+    if (anyOrder && left.type == StaticType::Bool && right.type == StaticType::Bool &&
+        Operators::isEquality(op))
+    {
+        expression = {"(" + left.text + " " + Operators::toLexeme(op) + " " + right.text + ")",
+                      StaticType::Bool, pure, constant};
+        return;
+    }
+
+    // Everything else goes through the runtime, which still needs no dispatch for numbers
+    const std::string operands = anyOrder
+                                     ? left.text + ", " + right.text
+                                     : "lox::Operands{" + left.text + ", " + right.text + "}";
+    StaticType type = StaticType::Bool;
+    if (Operators::isArithmetic(op))
+    {
+        const bool numbers = left.type == StaticType::Number && right.type == StaticType::Number;
+        type = op == BinaryOperator::Add && !numbers ? StaticType::Value : StaticType::Number;
+    }
+    const std::string name = operatorNames[static_cast<size_t>(op)];
+    expression = {"lox::binary<BinaryOperator::" + name + ">(" + operands + ")", type};
+}
+
+void Transpiler::visitGroupingExpression(const GroupingExpression& expr, Environment*)
+{
+    expression      = translate(expr.getExpression());
+    expression.text = "(" + expression.text + ")";
+}
+
+void Transpiler::visitVariableExpression(const VariableExpression& expr, Environment*)
+{
+    // Reading an undefined global is an error, and so may be reading a fallback
+    const auto& location = expr.getLocation();
+    const bool  pure     = location.kind != VariableLocation::Kind::Global && !location.fallback;
+    expression           = {load(location), StaticType::Value, pure};
+}
+
+void Transpiler::visitAssignmentExpression(const AssignmentExpression& expr, Environment*)
+{
+    expression = {assign(expr.getLocation(), translate(expr.getValue()).text)};
+}
+
+void Transpiler::visitLogicalExpression(const LogicalExpression& expr, Environment*)
+{
+    const Code left  = translate(expr.getLeft());
+    const Code right = translate(expr.getRight());
+
+    const char* function =
+        expr.getOperator() == LogicalOperator::And ? "lox::logicalAnd(" : "lox::logicalOr(";
+    expression = {function + left.text + ", [&] { return " + right.text + "; })",
+                  left.type == right.type ? left.type : StaticType::Value, left.pure && right.pure,
+                  left.constant && right.constant};
+}
+
+std::string Transpiler::arguments(const CallExpression& expr)
+{
+    if (expr.getArguments().size == 0)
+    {
+        return "";
+    }
+
+    // Braced initializers are evaluated left to right
+    std::string list;
+    for (ExpressionId argument : ast->get(expr.getArguments()))
+    {
+        list += (list.empty() ? "{" : ", ") + translate(argument).text;
+    }
+    return list + "}";
+}
+
+void Transpiler::visitCallExpression(const CallExpression& expr, Environment*)
+{
+    // The callee is evaluated and checked before the arguments
+    const std::string callee = translate(expr.getCallee()).text;
+    expression = {"lox::Callee(" + callee + ").call(" + arguments(expr) + ")"};
+}
+
+void Transpiler::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                   Environment*)
+{
+    visit(*this, *ast, expr.getAssignment());
+}
+
+void Transpiler::visitComparisonExpression(const ComparisonExpression& expr, Environment*)
+{
+    visit(*this, *ast, expr.getComparison());
+}
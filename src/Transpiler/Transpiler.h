@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Ast/Ast.h"
+#include "../Environment/Environment.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+
+// Source of the runtime every translated program starts with, Runtime.h and the headers it shares
+// with the interpreter, embedded at build time by EmbedRuntime.cmake
+extern const char* const transpilerRuntime;
+
+// Translates a resolved program to a standalone C++ translation unit, for the `compile` command.
+//
+// Each Lox function becomes a C++ function whose frame slots, as assigned by the Resolver, are
+// local variables; globals are an array indexed like the GlobalEnvironment. Expressions keep a
+// static type: a literal number, arithmetic on numbers or a negation is a C++ double, and a
+// comparison or `!` a bool, so operators on them need no dispatch. Everything else is a
+// lox::Value handled by the runtime exactly as the Evaluator would.
+class Transpiler : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    // Translates the program in `tree`. `frameSize` is the number of frame slots the top-level
+    // code needs, from the Resolver.
+    std::string transpile(const Ast& tree, const GlobalEnvironment& globals, uint32_t frameSize);
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    enum class StaticType
+    {
+        Value,
+        Number,  // double
+        Bool
+    };
+
+    // A translated expression. A pure one has no effects and cannot fail, and a constant one also
+    // reads no variable, so the order in which they are evaluated does not matter.
+    struct Code
+    {
+        std::string text;
+        StaticType  type     = StaticType::Value;
+        bool        pure     = false;
+        bool        constant = false;
+    };
+
+    const Ast* ast = nullptr;
+
+    // Result of the last expression visited
+    Code expression;
+
+    // Body of the function being translated
+    std::string body;
+    int         indentation = 0;
+    bool        inFunction  = false;
+
+    // Translated functions, and the number of functions seen so far
+    std::vector<std::string> functions;
+    std::vector<std::string> declarations;
+    uint32_t                 functionCount = 0;
+
+    // String constants, keyed by their ConstantPool entry
+    std::vector<std::string>                 strings;
+    std::unordered_map<const Value*, size_t> stringIndices;
+
+    Code translate(ExpressionId expr);
+    void line(const std::string& text);
+
+    // Body of one C++ function: declares `frameSize` slots, emits `prologue` and the statements
+    std::string frame(uint32_t                     frameSize,
+                      const std::string&           prologue,
+                      std::span<const StatementId> statements);
+
+    // `value` assigned to the variable at `location`
+    std::string store(const VariableLocation& location, const std::string& value) const;
+
+    // Value of the variable at `location`, and `value` assigned to it by a Lox assignment
+    std::string load(const VariableLocation& location) const;
+    std::string assign(const VariableLocation& location, const std::string& value) const;
+
+    // Test of the truthiness of `code`
+    static std::string condition(const Code& code);
+
+    // A branch or loop body, in braces
+    void nested(StatementId statement);
+
+    // Argument list of a call
+    std::string arguments(const CallExpression& expr);
+
+    static std::string slot(uint32_t index) { return "s" + std::to_string(index); }
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Value/Value.h"
+
+// Instructions are one byte, followed by their operands. Operands named in the comments are 16-bit
+// little-endian unless noted otherwise. An index or frame slot that does not fit in 16 bits is
+// preceded by a Wide instruction holding its upper 16 bits.
+enum class OpCode : uint8_t
+{
+    Wide,  // upper 16 bits of the first operand of the next instruction
+
+    Constant,  // index: push constants[index]
+    Nil,
+    True,
+    False,
+    Pop,
+
+    GetGlobal,     // index
+    SetGlobal,     // index: leaves the value on the stack
+    DefineGlobal,  // index: pops the value
+    GetLocal,      // frame slot
+    SetLocal,      // frame slot: leaves the value on the stack
+    DefineLocal,   // frame slot: pops the value
+    GetCell,       // frame slot holding a Cell
+    SetCell,       // frame slot holding a Cell: leaves the value on the stack
+    DefineCell,    // frame slot holding a Cell: pops the value
+    GetCapture,    // index into the running closure's captures
+    SetCapture,    // index into the running closure's captures: leaves the value on the stack
+    ClearLocals,   // frame slot, count: releases the locals of a block on exit
+
+    // Binary operators, in the order of BinaryOperator
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Equal,
+    NotEqual,
+    Greater,
+    GreaterEqual,
+    Less,
+    LessEqual,
+
+    Negate,
+    Not,
+
+    Print,
+
+    Jump,         // 32-bit offset: forward
+    JumpIfFalse,  // 32-bit offset: forward, if the top of the stack is falsy; does not pop
+    Loop,         // 32-bit offset: backward
+
+    // 32-bit offset: forward, if the top of the stack is not an undefined local; pops it otherwise
+    JumpIfDefined,
+
+    Call,      // 8-bit argument count: the callee is below its arguments
+    TailCall,  // 8-bit argument count: like Call, reusing the current frame
+    Closure,   // index into the program's functions
+    Return     // returns the top of the stack
+};
+
+// Bytecode and constants of one function
+struct Chunk
+{
+    std::vector<uint8_t> code;
+    std::vector<Value>   constants;
+};
+
+// A compiled function, along with the frame layout the Resolver computed for it
+struct FunctionProto
+{
+    std::string name;
+    Chunk       chunk;
+
+    uint32_t              arity     = 0;
+    uint32_t              frameSize = 0;
+    ScopeLayout           parameterScope;
+    std::vector<uint32_t> parameterSlots;
+    std::vector<Capture>  captures;
+};
+
+// Output of the Compiler: every function in the program, with the top-level script first
+struct Program
+{
+    std::vector<std::unique_ptr<FunctionProto>> functions;
+
+    const FunctionProto& script() const { return *functions.front(); }
+};
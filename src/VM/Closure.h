@@ -0,0 +1,49 @@
+#pragma once
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Function/Callable.h"
+#include "Chunk.h"
+
+class VM;
+
+// A compiled function together with the Cells of the variables it captures
+class Closure : public Callable
+{
+   public:
+    Closure(const FunctionProto& function, std::vector<Value> cells, VM& vm)
+        : function(function), captures(std::move(cells)), vm(vm)
+    {
+        if (!captures.isEmpty())
+        {
+            Collector::track(*this);
+        }
+    }
+
+    // The VM calls closures directly; this is for callers outside the dispatch loop
+    Value call(std::span<Value> arguments) const override;
+
+    int arity() const override { return function.arity; }
+
+    bool isTruthy() const override { return false; }
+
+    void print() const override { std::cout << "<fn " + function.name + ">" << std::endl; }
+
+    void references(std::vector<Object*>& referenced) const override
+    {
+        captures.references(referenced);
+    }
+    void clearReferences() override { captures.clear(); }
+
+    const FunctionProto& getFunction() const { return function; }
+    Environment&         getCaptures() const { return captures; }
+
+   private:
+    const FunctionProto& function;
+
+    mutable Environment captures;
+
+    VM& vm;
+};
@@ -0,0 +1,435 @@
+#include "Compiler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "../Evaluator/EvaluatorError.h"
+
+Program Compiler::compile(const Ast& tree, uint32_t frameSize)
+{
+    ast     = &tree;
+    program = Program();
+    program.functions.push_back(std::make_unique<FunctionProto>());
+    function            = program.functions.back().get();
+    function->name      = "script";
+    function->frameSize = frameSize;
+    constantIndices.clear();
+
+    for (StatementId statement : tree.getStatements())
+    {
+        visit(*this, tree, statement);
+    }
+    emit(OpCode::Nil);
+    emit(OpCode::Return);
+
+    return std::move(program);
+}
+
+void Compiler::emitByte(uint32_t byte)
+{
+    if (byte > std::numeric_limits<uint8_t>::max())
+    {
+        throw EvaluatorError("Too many arguments in one call.");
+    }
+    function->chunk.code.push_back(static_cast<uint8_t>(byte));
+}
+
+void Compiler::emitShort(uint16_t operand)
+{
+    function->chunk.code.push_back(static_cast<uint8_t>(operand & 0xff));
+    function->chunk.code.push_back(static_cast<uint8_t>(operand >> 8));
+}
+
+void Compiler::emitLong(uint32_t operand)
+{
+    emitShort(operand & 0xffff);
+    emitShort(operand >> 16);
+}
+
+void Compiler::emit(OpCode op, uint32_t operand)
+{
+    if (operand > std::numeric_limits<uint16_t>::max())
+    {
+        emit(OpCode::Wide);
+        emitShort(operand >> 16);
+    }
+    emit(op);
+    emitShort(operand & 0xffff);
+}
+
+size_t Compiler::emitJump(OpCode op)
+{
+    emit(op);
+    emitLong(0);
+    return function->chunk.code.size() - 4;
+}
+
+void Compiler::patchJump(size_t position)
+{
+    auto&        code   = function->chunk.code;
+    const size_t offset = code.size() - position - 4;
+    if (offset > std::numeric_limits<uint32_t>::max())
+    {
+        throw EvaluatorError("Too much code to jump over.");
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        code[position + i] = static_cast<uint8_t>(offset >> (8 * i));
+    }
+}
+
+void Compiler::emitLoop(size_t start)
+{
+    // The offset is taken from just after the operand
+    const size_t offset = function->chunk.code.size() + 5 - start;
+    if (offset > std::numeric_limits<uint32_t>::max())
+    {
+        throw EvaluatorError("Loop body too large.");
+    }
+    emit(OpCode::Loop);
+    emitLong(offset);
+}
+
+void Compiler::emitGet(const VariableLocation& location)
+{
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            emit(OpCode::GetGlobal, location.index);
+            break;
+        case VariableLocation::Kind::Frame:
+            emit(OpCode::GetLocal, location.index);
+            break;
+        case VariableLocation::Kind::Cell:
+            emit(OpCode::GetCell, location.index);
+            break;
+        case VariableLocation::Kind::Capture:
+            emit(OpCode::GetCapture, location.index);
+            break;
+    }
+
+    // While the local is undefined, read the variable the name referred to before it
+    if (location.fallback)
+    {
+        const size_t definedJump = emitJump(OpCode::JumpIfDefined);
+        emitGet(*location.fallback);
+        patchJump(definedJump);
+    }
+}
+
+void Compiler::emitSet(const VariableLocation& location)
+{
+    // While the local is undefined, assign the variable the name referred to before it
+    if (location.fallback)
+    {
+        VariableLocation local = location;
+        local.fallback         = nullptr;
+
+        emitGet(local);
+        const size_t definedJump = emitJump(OpCode::JumpIfDefined);
+        emitSet(*location.fallback);
+        const size_t endJump = emitJump(OpCode::Jump);
+        patchJump(definedJump);
+        emit(OpCode::Pop);
+        emitSet(local);
+        patchJump(endJump);
+        return;
+    }
+
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            emit(OpCode::SetGlobal, location.index);
+            break;
+        case VariableLocation::Kind::Frame:
+            emit(OpCode::SetLocal, location.index);
+            break;
+        case VariableLocation::Kind::Cell:
+            emit(OpCode::SetCell, location.index);
+            break;
+        case VariableLocation::Kind::Capture:
+            emit(OpCode::SetCapture, location.index);
+            break;
+    }
+}
+
+void Compiler::emitDefine(const VariableLocation& location)
+{
+    switch (location.kind)
+    {
+        case VariableLocation::Kind::Global:
+            emit(OpCode::DefineGlobal, location.index);
+            break;
+        case VariableLocation::Kind::Frame:
+            emit(OpCode::DefineLocal, location.index);
+            break;
+        case VariableLocation::Kind::Cell:
+            emit(OpCode::DefineCell, location.index);
+            break;
+        case VariableLocation::Kind::Capture:
+            // Declarations are always in the declaring function's own scopes
+            emitSet(location);
+            emit(OpCode::Pop);
+            break;
+    }
+}
+
+void Compiler::visitPrintStatement(const PrintStatement& statement, Environment* env)
+{
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+        emit(OpCode::Print);
+    }
+}
+
+void Compiler::visitExpressionStatement(const ExpressionStatement& statement, Environment* env)
+{
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+        emit(statement.toPrint() ? OpCode::Print : OpCode::Pop);
+    }
+}
+
+void Compiler::visitVariableStatement(const VariableStatement& statement, Environment* env)
+{
+    if (statement.getInitializer())
+    {
+        visit(*this, *ast, statement.getInitializer());
+    }
+    else
+    {
+        emit(OpCode::Nil);
+    }
+    emitDefine(statement.getLocation());
+}
+
+void Compiler::visitBlockStatement(const BlockStatement& statement, Environment* env)
+{
+    for (StatementId stmnt : ast->get(statement.getStatements()))
+    {
+        visit(*this, *ast, stmnt);
+    }
+
+    const auto& scope = statement.getScope();
+    // The count has no Wide form, so a larger block is cleared in parts
+    constexpr uint32_t maxCount = std::numeric_limits<uint16_t>::max();
+    for (uint32_t cleared = 0; cleared < scope.slotCount; cleared += maxCount)
+    {
+        emit(OpCode::ClearLocals, scope.frameOffset + cleared);
+        emitShort(std::min(scope.slotCount - cleared, maxCount));
+    }
+}
+
+void Compiler::visitIfStatement(const IfStatement& statement, Environment* env)
+{
+    visit(*this, *ast, statement.getCondition());
+    const size_t elseJump = emitJump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+    visit(*this, *ast, statement.getThenBranch());
+
+    const size_t endJump = emitJump(OpCode::Jump);
+    patchJump(elseJump);
+    emit(OpCode::Pop);
+    if (statement.getElseBranch())
+    {
+        visit(*this, *ast, statement.getElseBranch());
+    }
+    patchJump(endJump);
+}
+
+void Compiler::visitWhileStatement(const WhileStatement& statement, Environment* env)
+{
+    const size_t start = function->chunk.code.size();
+    visit(*this, *ast, statement.getCondition());
+    const size_t exitJump = emitJump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+    visit(*this, *ast, statement.getBody());
+    emitLoop(start);
+
+    patchJump(exitJump);
+    emit(OpCode::Pop);
+}
+
+void Compiler::visitForStatement(const ForStatement& statement, Environment* env)
+{
+    if (statement.getInitializer())
+    {
+        visit(*this, *ast, statement.getInitializer());
+    }
+
+    const size_t start    = function->chunk.code.size();
+    size_t       exitJump = 0;
+    if (statement.getCondition())
+    {
+        visit(*this, *ast, statement.getCondition());
+        exitJump = emitJump(OpCode::JumpIfFalse);
+        emit(OpCode::Pop);
+    }
+
+    visit(*this, *ast, statement.getBody());
+    if (statement.getIncrement())
+    {
+        visit(*this, *ast, statement.getIncrement());
+        emit(OpCode::Pop);
+    }
+    emitLoop(start);
+
+    if (statement.getCondition())
+    {
+        patchJump(exitJump);
+        emit(OpCode::Pop);
+    }
+}
+
+void Compiler::visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement,
+                                                Environment*                       env)
+{
+    auto proto            = std::make_unique<FunctionProto>();
+    proto->name           = ast->getString(statement.getName());
+    proto->arity          = statement.getParameters().size;
+    proto->frameSize      = statement.getFrameSize();
+    proto->parameterScope = statement.getParameterScope();
+    proto->parameterSlots = statement.getParameterSlots();
+    proto->captures       = statement.getCaptures();
+
+    const uint32_t index = program.functions.size();
+    program.functions.push_back(std::move(proto));
+
+    FunctionProto* enclosing          = function;
+    auto           enclosingConstants = std::move(constantIndices);
+    function                          = program.functions.back().get();
+    constantIndices.clear();
+
+    visit(*this, *ast, statement.getBody());
+    emit(OpCode::Nil);
+    emit(OpCode::Return);
+
+    function        = enclosing;
+    constantIndices = std::move(enclosingConstants);
+
+    emit(OpCode::Closure, index);
+    emitDefine(statement.getLocation());
+}
+
+void Compiler::visitReturnStatement(const ReturnStatement& statement, Environment* env)
+{
+    if (statement.isTailCall())
+    {
+        const auto& call = ast->get<CallExpression>(statement.getExpression());
+        visit(*this, *ast, call.getCallee());
+        for (ExpressionId argument : ast->get(call.getArguments()))
+        {
+            visit(*this, *ast, argument);
+        }
+        emit(OpCode::TailCall);
+        emitByte(call.getArguments().size);
+        return;
+    }
+
+    if (statement.getExpression())
+    {
+        visit(*this, *ast, statement.getExpression());
+    }
+    else
+    {
+        emit(OpCode::Nil);
+    }
+    emit(OpCode::Return);
+}
+
+void Compiler::visitLiteralExpression(const LiteralExpression& expr, Environment* env)
+{
+    const Value& constant = expr.getConstant();
+    if (constant.isNil())
+    {
+        emit(OpCode::Nil);
+        return;
+    }
+    if (constant.isBool())
+    {
+        emit(constant.asBool() ? OpCode::True : OpCode::False);
+        return;
+    }
+
+    auto [it, inserted] = constantIndices.try_emplace(&constant, function->chunk.constants.size());
+    if (inserted)
+    {
+        function->chunk.constants.push_back(constant);
+    }
+    emit(OpCode::Constant, it->second);
+}
+
+void Compiler::visitUnaryExpression(const UnaryExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getRight());
+    emit(expr.getOperator() == UnaryOperator::Negate ? OpCode::Negate : OpCode::Not);
+}
+
+void Compiler::visitBinaryExpression(const BinaryExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getLeft());
+    visit(*this, *ast, expr.getRight());
+    emit(static_cast<OpCode>(static_cast<uint8_t>(OpCode::Add) +
+                             static_cast<uint8_t>(expr.getOperator())));
+}
+
+void Compiler::visitGroupingExpression(const GroupingExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getExpression());
+}
+
+void Compiler::visitVariableExpression(const VariableExpression& expr, Environment* env)
+{
+    emitGet(expr.getLocation());
+}
+
+void Compiler::visitAssignmentExpression(const AssignmentExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getValue());
+    emitSet(expr.getLocation());
+}
+
+void Compiler::visitLogicalExpression(const LogicalExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getLeft());
+
+    // Short-circuits with the left operand on the stack as the result
+    size_t endJump;
+    if (expr.getOperator() == LogicalOperator::And)
+    {
+        endJump = emitJump(OpCode::JumpIfFalse);
+    }
+    else
+    {
+        const size_t elseJump = emitJump(OpCode::JumpIfFalse);
+        endJump               = emitJump(OpCode::Jump);
+        patchJump(elseJump);
+    }
+    emit(OpCode::Pop);
+    visit(*this, *ast, expr.getRight());
+    patchJump(endJump);
+}
+
+void Compiler::visitCallExpression(const CallExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getCallee());
+    for (ExpressionId argument : ast->get(expr.getArguments()))
+    {
+        visit(*this, *ast, argument);
+    }
+    emit(OpCode::Call);
+    emitByte(expr.getArguments().size);
+}
+
+void Compiler::visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr,
+                                                 Environment*                        env)
+{
+    visit(*this, *ast, expr.getAssignment(), env);
+}
+
+void Compiler::visitComparisonExpression(const ComparisonExpression& expr, Environment* env)
+{
+    visit(*this, *ast, expr.getComparison(), env);
+}
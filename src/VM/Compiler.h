@@ -0,0 +1,71 @@
+#pragma once
+#include <unordered_map>
+
+#include "../Ast/Ast.h"
+#include "../Expression/ExpressionVisitor.h"
+#include "../Statement/StatementVisitor.h"
+#include "Chunk.h"
+
+// Lowers a resolved program to bytecode for the VM. Variable locations, frame layouts and captures
+// are taken from the Resolver's annotations, so frames on the VM's stack are laid out exactly as
+// the Evaluator's.
+class Compiler : public ExpressionVisitor<void>, public StatementVisitor<void>
+{
+   public:
+    // Compiles the program in `tree`. `frameSize` is the number of frame slots the top-level code
+    // needs, from the Resolver.
+    Program compile(const Ast& tree, uint32_t frameSize);
+
+    // clang-format off
+    // Statement visitor methods
+    void visitPrintStatement(const PrintStatement& statement, Environment* env) override;
+    void visitExpressionStatement(const ExpressionStatement& statement, Environment* env) override;
+    void visitVariableStatement(const VariableStatement& statement, Environment* env) override;
+    void visitBlockStatement(const BlockStatement& statement, Environment* env) override;
+    void visitIfStatement(const IfStatement& statement, Environment* env) override;
+    void visitWhileStatement(const WhileStatement& statement, Environment* env) override;
+    void visitForStatement(const ForStatement& statement, Environment* env) override;
+    void visitFunctionDefinitionStatement(const FunctionDefinitionStatement& statement, Environment* env) override;
+    void visitReturnStatement(const ReturnStatement& statement, Environment* env) override;
+
+    // Expression visitor methods
+    void visitLiteralExpression(const LiteralExpression& expr, Environment* env) override;
+    void visitUnaryExpression(const UnaryExpression& expr, Environment* env) override;
+    void visitBinaryExpression(const BinaryExpression& expr, Environment* env) override;
+    void visitGroupingExpression(const GroupingExpression& expr, Environment* env) override;
+    void visitVariableExpression(const VariableExpression& expr, Environment* env) override;
+    void visitAssignmentExpression(const AssignmentExpression& expr, Environment* env) override;
+    void visitLogicalExpression(const LogicalExpression& expr, Environment* env) override;
+    void visitCallExpression(const CallExpression& expr, Environment* env) override;
+    void visitCompoundAssignmentExpression(const CompoundAssignmentExpression& expr, Environment* env) override;
+    void visitComparisonExpression(const ComparisonExpression& expr, Environment* env) override;
+    // clang-format on
+
+   private:
+    const Ast* ast = nullptr;
+
+    Program program;
+
+    // Function being compiled
+    FunctionProto* function = nullptr;
+
+    // Index of each literal in the current function's constants, keyed by its ConstantPool entry
+    std::unordered_map<const Value*, uint32_t> constantIndices;
+
+    void emit(OpCode op) { function->chunk.code.push_back(static_cast<uint8_t>(op)); }
+    void emitByte(uint32_t byte);
+    void emitShort(uint16_t operand);
+    void emitLong(uint32_t operand);
+
+    // Emits `op` with a 16-bit operand, preceded by a Wide instruction if `operand` needs one
+    void emit(OpCode op, uint32_t operand);
+
+    // Emits a forward jump and returns the position of its offset, to be patched
+    size_t emitJump(OpCode op);
+    void   patchJump(size_t position);
+    void   emitLoop(size_t start);
+
+    void emitGet(const VariableLocation& location);
+    void emitSet(const VariableLocation& location);
+    void emitDefine(const VariableLocation& location);
+};
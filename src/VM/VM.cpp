@@ -0,0 +1,360 @@
+#include "VM.h"
+
+#include "../Evaluator/EvaluatorError.h"
+#include "../Operators/Operators.h"
+
+Value Closure::call(std::span<Value> arguments) const
+{
+    return vm.call(*this, arguments);
+}
+
+void VM::run()
+{
+    const FunctionProto& script = program.script();
+
+    // The script has no callee; a nil placeholder keeps the frame layout uniform
+    stack.emplace_back();
+    stack.resize(1 + script.frameSize, Value::undefined());
+    frames.push_back({&script, nullptr, script.chunk.code.data(), 1});
+    execute(0);
+}
+
+Value VM::call(const Closure& closure, std::span<Value> arguments)
+{
+    // The arguments may be a view of this stack, so copy them before it grows
+    std::vector<Value> copies(arguments.begin(), arguments.end());
+
+    stack.emplace_back(const_cast<Closure*>(&closure));
+    for (auto& argument : copies)
+    {
+        stack.push_back(std::move(argument));
+    }
+    enterFrame(closure, stack.size() - copies.size());
+    execute(frames.size() - 1);
+
+    Value result = std::move(stack.back());
+    stack.pop_back();
+    return result;
+}
+
+template <BinaryOperator Op>
+void VM::binary()
+{
+    // With the operator known at compile time, the number fast path in Operators::binary reduces
+    // to a single operation
+    Value& left = stack[stack.size() - 2];
+    left        = Operators::binary(Op, left, stack.back());
+    stack.pop_back();
+}
+
+Cell& VM::cellAt(size_t slot)
+{
+    return cellIn(stack[slot]);
+}
+
+void VM::enterFrame(const Closure& closure, size_t base)
+{
+    const FunctionProto& function = closure.getFunction();
+    ::enterFrame(stack, base, function.parameterSlots, function.parameterScope, function.frameSize);
+    frames.push_back({&function, &closure, function.chunk.code.data(), base});
+}
+
+bool VM::callValue(size_t argumentCount)
+{
+    const size_t argumentBase = stack.size() - argumentCount;
+    const Value& callee       = stack[argumentBase - 1];
+    if (!callee.isCallable())
+    {
+        throw EvaluatorError("Attempt to call a non-function object");
+    }
+
+    auto callable = static_cast<const Callable*>(callee.asObject());
+    if (argumentCount != static_cast<size_t>(callable->arity()))
+    {
+        throw EvaluatorError("Incorrect number of arguments to function.");
+    }
+
+    if (auto closure = dynamic_cast<const Closure*>(callable))
+    {
+        enterFrame(*closure, argumentBase);
+        return true;
+    }
+
+    Value result = callable->call({stack.data() + argumentBase, argumentCount});
+    stack.resize(argumentBase - 1);
+    stack.push_back(std::move(result));
+    return false;
+}
+
+void VM::execute(size_t exitDepth)
+{
+    CallFrame*     frame     = &frames.back();
+    const uint8_t* ip        = frame->ip;
+    const Value*   constants = frame->function->chunk.constants.data();
+    size_t         base      = frame->base;
+
+    // Upper bits of the next 16-bit operand, set by a Wide instruction
+    uint32_t wide = 0;
+
+    auto readByte  = [&]() { return *ip++; };
+    auto readShort = [&]()
+    {
+        const uint32_t operand = wide | ip[0] | (ip[1] << 8);
+        wide                   = 0;
+        ip += 2;
+        return operand;
+    };
+    auto readLong = [&]()
+    {
+        const uint32_t operand = ip[0] | (ip[1] << 8) | (ip[2] << 16) | (uint32_t(ip[3]) << 24);
+        ip += 4;
+        return operand;
+    };
+    auto pop = [&]()
+    {
+        Value value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+
+    // Reloads the cached state of the innermost frame after a call or return
+    auto loadFrame = [&]()
+    {
+        frame     = &frames.back();
+        ip        = frame->ip;
+        constants = frame->function->chunk.constants.data();
+        base      = frame->base;
+    };
+
+    while (true)
+    {
+        const auto op = static_cast<OpCode>(readByte());
+        switch (op)
+        {
+            case OpCode::Wide:
+                wide = readShort() << 16;
+                break;
+
+            case OpCode::Constant:
+                stack.push_back(constants[readShort()]);
+                break;
+            case OpCode::Nil:
+                stack.emplace_back();
+                break;
+            case OpCode::True:
+                stack.emplace_back(true);
+                break;
+            case OpCode::False:
+                stack.emplace_back(false);
+                break;
+            case OpCode::Pop:
+                stack.pop_back();
+                break;
+
+            case OpCode::GetGlobal:
+                stack.push_back(globals.get(readShort()));
+                break;
+            case OpCode::SetGlobal:
+                globals.assign(readShort(), stack.back());
+                break;
+            case OpCode::DefineGlobal:
+            {
+                const uint32_t index = readShort();
+                globals.define(index, pop());
+                break;
+            }
+            case OpCode::GetLocal:
+                stack.push_back(stack[base + readShort()]);
+                break;
+            case OpCode::SetLocal:
+                stack[base + readShort()] = stack.back();
+                break;
+            case OpCode::DefineLocal:
+            {
+                const size_t slot = base + readShort();
+                stack[slot]       = pop();
+                break;
+            }
+            case OpCode::GetCell:
+            {
+                Value value = cellAt(base + readShort()).value;
+                stack.push_back(std::move(value));
+                break;
+            }
+            case OpCode::SetCell:
+                cellAt(base + readShort()).value = stack.back();
+                break;
+            case OpCode::DefineCell:
+            {
+                Cell& cell = cellAt(base + readShort());
+                cell.value = pop();
+                break;
+            }
+            case OpCode::GetCapture:
+                stack.push_back(frame->closure->getCaptures().get(readShort()));
+                break;
+            case OpCode::SetCapture:
+                frame->closure->getCaptures().assign(readShort(), stack.back());
+                break;
+            case OpCode::ClearLocals:
+            {
+                const size_t begin = base + readShort();
+                const size_t count = readShort();
+                for (size_t slot = begin; slot < begin + count; ++slot)
+                {
+                    stack[slot] = Value::undefined();
+                }
+                break;
+            }
+
+            case OpCode::Add:
+                binary<BinaryOperator::Add>();
+                break;
+            case OpCode::Subtract:
+                binary<BinaryOperator::Subtract>();
+                break;
+            case OpCode::Multiply:
+                binary<BinaryOperator::Multiply>();
+                break;
+            case OpCode::Divide:
+                binary<BinaryOperator::Divide>();
+                break;
+            case OpCode::Equal:
+                binary<BinaryOperator::Equal>();
+                break;
+            case OpCode::NotEqual:
+                binary<BinaryOperator::NotEqual>();
+                break;
+            case OpCode::Greater:
+                binary<BinaryOperator::Greater>();
+                break;
+            case OpCode::GreaterEqual:
+                binary<BinaryOperator::GreaterEqual>();
+                break;
+            case OpCode::Less:
+                binary<BinaryOperator::Less>();
+                break;
+            case OpCode::LessEqual:
+                binary<BinaryOperator::LessEqual>();
+                break;
+            case OpCode::Negate:
+                stack.back() = Operators::unary(UnaryOperator::Negate, stack.back());
+                break;
+            case OpCode::Not:
+                stack.back() = Operators::unary(UnaryOperator::Not, stack.back());
+                break;
+
+            case OpCode::Print:
+                pop().print();
+                break;
+
+            case OpCode::Jump:
+            {
+                const uint32_t offset = readLong();
+                ip += offset;
+                break;
+            }
+            case OpCode::JumpIfFalse:
+            {
+                const uint32_t offset = readLong();
+                if (!stack.back().isTruthy())
+                {
+                    ip += offset;
+                }
+                break;
+            }
+            case OpCode::Loop:
+            {
+                const uint32_t offset = readLong();
+                ip -= offset;
+                break;
+            }
+            case OpCode::JumpIfDefined:
+            {
+                const uint32_t offset = readLong();
+                if (!stack.back().isUndefined())
+                {
+                    ip += offset;
+                }
+                else
+                {
+                    stack.pop_back();
+                }
+                break;
+            }
+
+            case OpCode::Call:
+            {
+                const size_t argumentCount = readByte();
+                frame->ip                  = ip;
+                if (callValue(argumentCount))
+                {
+                    loadFrame();
+                }
+                break;
+            }
+            case OpCode::TailCall:
+            {
+                const size_t argumentCount = readByte();
+                frame->ip                  = ip;
+
+                // Move the callee and its arguments down over the current frame, then replace it
+                const size_t calleeSlot = stack.size() - argumentCount - 1;
+                for (size_t i = 0; i <= argumentCount; ++i)
+                {
+                    stack[base - 1 + i] = std::move(stack[calleeSlot + i]);
+                }
+                stack.resize(base + argumentCount);
+                frames.pop_back();
+
+                if (callValue(argumentCount))
+                {
+                    loadFrame();
+                    break;
+                }
+
+                // A native callee has already returned; its result is in place of the frame
+                if (frames.size() == exitDepth)
+                {
+                    return;
+                }
+                loadFrame();
+                break;
+            }
+            case OpCode::Closure:
+            {
+                const FunctionProto& function = *program.functions[readShort()];
+
+                std::vector<Value> cells;
+                cells.reserve(function.captures.size());
+                for (const auto& capture : function.captures)
+                {
+                    if (capture.fromFrame)
+                    {
+                        cellAt(base + capture.index);
+                        cells.push_back(stack[base + capture.index]);
+                    }
+                    else
+                    {
+                        cells.push_back(frame->closure->getCaptures().getCell(capture.index));
+                    }
+                }
+                stack.emplace_back(new Closure(function, std::move(cells), *this));
+                break;
+            }
+            case OpCode::Return:
+            {
+                Value result = pop();
+                stack.resize(frame->base - 1);
+                stack.push_back(std::move(result));
+                frames.pop_back();
+                if (frames.size() == exitDepth)
+                {
+                    return;
+                }
+                loadFrame();
+                break;
+            }
+        }
+    }
+}
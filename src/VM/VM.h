@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../Environment/Environment.h"
+#include "../Operators/Operators.h"
+#include "Chunk.h"
+#include "Closure.h"
+
+// Stack-based bytecode interpreter for programs produced by the Compiler. Like the Evaluator, a
+// call's arguments become the start of the callee's frame; the callee itself sits in the slot just
+// below the frame, which keeps it alive for the duration of the call.
+class VM
+{
+   public:
+    VM(GlobalEnvironment& globals, const Program& program) : globals(globals), program(program)
+    {
+        stack.reserve(initialStackSize);
+    }
+
+    void run();
+
+    // Runs `closure` to completion from outside the dispatch loop
+    Value call(const Closure& closure, std::span<Value> arguments);
+
+   private:
+    struct CallFrame
+    {
+        const FunctionProto* function;
+        const Closure*       closure;  // Null for the top-level script
+        const uint8_t*       ip;
+        size_t               base;
+    };
+
+    static constexpr size_t initialStackSize = 1024;
+
+    GlobalEnvironment& globals;
+    const Program&     program;
+
+    std::vector<Value>     stack;
+    std::vector<CallFrame> frames;
+
+    // Runs until the frame count drops back to `exitDepth`
+    void execute(size_t exitDepth);
+
+    // Pushes a frame for `closure`, whose arguments start at `base`
+    void enterFrame(const Closure& closure, size_t base);
+
+    // Calls the callee below the top `argumentCount` values. Returns true if a frame was pushed;
+    // native functions are called immediately and leave their result on the stack.
+    bool callValue(size_t argumentCount);
+
+    // Replaces the top two values with the result of a binary operator
+    template <BinaryOperator Op>
+    void binary();
+
+    // Cell of the captured local at stack position `slot`, created if its declaration has not run
+    Cell& cellAt(size_t slot);
+};
@@ -0,0 +1,173 @@
+#include "Collector.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Object.h"
+
+namespace
+{
+
+// Reference count of an object found reachable during a collection
+constexpr uint32_t reachable = std::numeric_limits<uint32_t>::max();
+
+}  // namespace
+
+Collector::Heap& Collector::heap()
+{
+    // Never destroyed, so objects released during static destruction can still untrack themselves
+    static Heap* instance = new Heap;
+    return *instance;
+}
+
+void Collector::insert(Object& object, Generation generation)
+{
+    auto& objects     = heap().generations[generation];
+    object.generation = generation;
+    object.heapIndex  = static_cast<uint32_t>(objects.size());
+    objects.push_back(&object);
+}
+
+void Collector::track(Object& object)
+{
+    Heap& state = heap();
+    if (!state.collecting && state.generations[Young].size() >= youngLimit)
+    {
+        collect(Young);
+        if (state.generations[Old].size() >= state.oldLimit)
+        {
+            collect(Old);
+            state.oldLimit = std::max(minimumOldLimit, 2 * state.generations[Old].size());
+        }
+    }
+    insert(object, Young);
+}
+
+void Collector::untrack(Object& object)
+{
+    auto& objects             = heap().generations[object.generation];
+    objects[object.heapIndex] = objects.back();
+    objects.back()->heapIndex = object.heapIndex;
+    objects.pop_back();
+    object.heapIndex = Object::untracked;
+}
+
+void Collector::collectAll()
+{
+    if (!heap().collecting)
+    {
+        collect(Old);
+    }
+}
+
+void Collector::untrackIf(const std::function<bool(const Object&)>& released)
+{
+    for (auto& objects : heap().generations)
+    {
+        // Untracking moves the last object into the freed position, so walk from the end
+        for (size_t index = objects.size(); index-- > 0;)
+        {
+            if (released(*objects[index]))
+            {
+                untrack(*objects[index]);
+            }
+        }
+    }
+}
+
+void Collector::collect(Generation generation)
+{
+    Heap& state      = heap();
+    state.collecting = true;
+
+    // A young collection treats references from old objects as external. A full one examines
+    // every tracked object.
+    if (generation == Old)
+    {
+        for (Object* object : state.generations[Young])
+        {
+            insert(*object, Old);
+        }
+        state.generations[Young].clear();
+    }
+    const std::vector<Object*> objects = state.generations[generation];
+
+    // References from outside the generation are what remains of the counts once the references
+    // its objects hold on each other are subtracted
+    std::vector<Object*> referenced;
+    for (Object* object : objects)
+    {
+        object->gcCount = object->refCount;
+    }
+    for (Object* object : objects)
+    {
+        referenced.clear();
+        object->references(referenced);
+        for (Object* child : referenced)
+        {
+            if (child->isTracked() && child->generation == generation)
+            {
+                --child->gcCount;
+            }
+        }
+    }
+
+    // Objects referenced from outside, or not yet owned by any Value because they are still being
+    // created, are reachable, and so is everything they refer to
+    std::vector<Object*> pending;
+    for (Object* object : objects)
+    {
+        if (object->gcCount > 0 || object->refCount == 0)
+        {
+            object->gcCount = reachable;
+            pending.push_back(object);
+        }
+    }
+    while (!pending.empty())
+    {
+        Object* object = pending.back();
+        pending.pop_back();
+
+        referenced.clear();
+        object->references(referenced);
+        for (Object* child : referenced)
+        {
+            if (child->isTracked() && child->generation == generation &&
+                child->gcCount != reachable)
+            {
+                child->gcCount = reachable;
+                pending.push_back(child);
+            }
+        }
+    }
+
+    // The garbage is held while its references are dropped, so no object of a cycle is destroyed
+    // while another one still refers to it
+    std::vector<Object*> garbage;
+    for (Object* object : objects)
+    {
+        if (object->gcCount != reachable)
+        {
+            object->retain();
+            garbage.push_back(object);
+        }
+    }
+    for (Object* object : garbage)
+    {
+        object->clearReferences();
+    }
+    for (Object* object : garbage)
+    {
+        object->release();
+    }
+
+    if (generation == Young)
+    {
+        for (Object* object : state.generations[Young])
+        {
+            insert(*object, Old);
+        }
+        state.generations[Young].clear();
+    }
+    state.collecting = false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Object;
+
+// Reclaims reference cycles, which reference counting alone never frees: a closure that captures
+// a variable holding the closure itself, or closures that capture each other.
+//
+// Objects that can hold references (Cells and functions with captures) are tracked from the
+// moment they are created. A collection finds the tracked objects that are referenced from
+// outside the tracked set, by subtracting the references tracked objects hold on each other from
+// their reference counts, and marks everything reachable from them. What is left is only kept
+// alive by cycles and is freed. As the reference counts account for every holder, including the
+// engines' stacks, the globals and Values held by C++ code, no roots need to be registered.
+//
+// Collections are generational: objects start young, most young collections find them either
+// garbage or promote them, and the older generation is only examined once it has grown enough.
+class Collector
+{
+   public:
+    // Starts tracking a newly created object, running a collection first if enough objects were
+    // created since the last one
+    static void track(Object& object);
+    static void untrack(Object& object);
+
+    // Frees every cycle nothing outside it refers to, whatever its generation
+    static void collectAll();
+
+    // Stops tracking the objects `released` selects, whose memory is about to go away
+    static void untrackIf(const std::function<bool(const Object&)>& released);
+
+   private:
+    enum Generation : uint8_t
+    {
+        Young,
+        Old,
+
+        GenerationCount
+    };
+
+    // Tracked objects created since the last collection after which a young collection runs
+    static constexpr size_t youngLimit = 2000;
+
+    // Smallest number of old objects after which a full collection runs
+    static constexpr size_t minimumOldLimit = 10000;
+
+    struct Heap
+    {
+        std::vector<Object*> generations[GenerationCount];
+        size_t               oldLimit   = minimumOldLimit;
+        bool                 collecting = false;
+    };
+
+    static Heap& heap();
+
+    // Frees the unreachable objects of `generation`, then moves the survivors to the old one
+    static void collect(Generation generation);
+
+    // Adds `object` to the end of `generation`
+    static void insert(Object& object, Generation generation);
+};
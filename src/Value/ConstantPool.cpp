@@ -0,0 +1,35 @@
+#include "ConstantPool.h"
+
+#include <cstring>
+
+const Value& ConstantPool::add(Value value)
+{
+    constants.push_back(std::move(value));
+    return constants.back();
+}
+
+const Value& ConstantPool::addNumber(double number)
+{
+    // Key on the bit pattern so that 0 and -0 stay distinct
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(double));
+
+    auto it = numbers.find(bits);
+    if (it != numbers.end())
+    {
+        return constants[it->second];
+    }
+    numbers.emplace(bits, constants.size());
+    return add(Value(number));
+}
+
+const Value& ConstantPool::addString(const std::string& text)
+{
+    auto it = strings.find(text);
+    if (it != strings.end())
+    {
+        return constants[it->second];
+    }
+    strings.emplace(text, constants.size());
+    return add(Value(text));
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "Value.h"
+
+// Owns every constant Value that appears in a program's source. Literals are converted once at
+// parse time and de-duplicated, so all occurrences of the same string literal share one
+// StringObject and evaluating a literal is just a Value copy.
+class ConstantPool
+{
+   public:
+    const Value& addNumber(double number);
+    const Value& addString(const std::string& text);
+    const Value& addBoolean(bool boolean) const { return boolean ? trueConstant : falseConstant; }
+    const Value& addNil() const { return nilConstant; }
+
+    size_t size() const { return constants.size(); }
+
+   private:
+    // A deque keeps references to existing entries valid as the pool grows
+    std::deque<Value> constants;
+
+    const Value trueConstant{true};
+    const Value falseConstant{false};
+    const Value nilConstant;
+
+    std::unordered_map<uint64_t, size_t>    numbers;
+    std::unordered_map<std::string, size_t> strings;
+
+    const Value& add(Value value);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+// Prints a number on a line of its own the way `print` does: a whole number without a fraction,
+// anything else with six significant digits. Shared with the runtime of translated programs, see
+// Transpiler/Runtime.h.
+inline void printNumber(double value)
+{
+    double intPart;
+    if (std::modf(value, &intPart) == 0)
+    {
+        std::cout << std::fixed << std::setprecision(0) << value << std::endl;
+        std::cout.unsetf(std::ios::fixed | std::ios::scientific);
+        std::cout.precision(6);
+    }
+    else
+    {
+        std::cout << value << std::endl;
+    }
+}
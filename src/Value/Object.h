@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Collector.h"
+#include "Pool.h"
+
+// Base class for every heap-allocated runtime value (strings, callables and the cells of captured
+// variables). Numbers, booleans and nil never allocate; they are stored inline in a Value.
+class Object
+{
+   public:
+    enum class Kind : uint8_t
+    {
+        String,
+        Callable,
+        Cell
+    };
+
+    explicit Object(Kind kind) : kind(kind) {}
+    virtual ~Object()
+    {
+        if (isTracked())
+        {
+            Collector::untrack(*this);
+        }
+    }
+
+    Object(const Object&)            = delete;
+    Object& operator=(const Object&) = delete;
+
+    // Objects come from the Pool. The destructor is virtual, so `size` is that of the actual type.
+    static void* operator new(size_t size) { return Pool::allocate(size); }
+    static void  operator delete(void* block, size_t size) { Pool::deallocate(block, size); }
+
+    Kind getKind() const { return kind; }
+
+    virtual bool isTruthy() const = 0;
+    virtual void print() const    = 0;
+
+    // Appends the objects this one holds a reference to. Objects that override it can be part of
+    // a cycle, and must be tracked by the Collector once created.
+    virtual void references([[maybe_unused]] std::vector<Object*>& referenced) const {}
+
+    // Drops every reference the object holds, to break a cycle the Collector frees
+    virtual void clearReferences() {}
+
+    // Intrusive, non-atomic reference count managed by Value. The interpreter is single-threaded
+    // so there is no need to pay for the atomic operations std::shared_ptr does.
+    void retain() { ++refCount; }
+    void release()
+    {
+        if (--refCount == 0)
+        {
+            delete this;
+        }
+    }
+
+   private:
+    friend class Collector;
+
+    static constexpr uint32_t untracked = UINT32_MAX;
+
+    bool isTracked() const { return heapIndex != untracked; }
+
+    const Kind kind;
+    uint8_t    generation = 0;
+    uint32_t   refCount   = 0;
+
+    // Position in the Collector's generation, and scratch count used while collecting
+    uint32_t heapIndex = untracked;
+    uint32_t gcCount   = 0;
+};
+
+class StringObject : public Object
+{
+   public:
+    explicit StringObject(std::string value) : Object(Kind::String), value(std::move(value)) {}
+
+    const std::string& getValue() const { return value; }
+
+    bool isTruthy() const override { return true; }
+    void print() const override { std::cout << value << std::endl; }
+
+   private:
+    const std::string value;
+};
@@ -0,0 +1,169 @@
+#include "Pool.h"
+
+#include <new>
+#include <unordered_set>
+
+#include "Collector.h"
+#include "Object.h"
+
+Pool::~Pool()
+{
+    // Whatever the run left in cycles is destroyed properly rather than dropped with its chunk, and
+    // the Collector forgets anything still tracked here so it keeps no dangling pointers
+    Collector::collectAll();
+
+    std::unordered_set<const Chunk*> owned;
+    for (const Chunk* chunk = chunks; chunk; chunk = chunk->next)
+    {
+        owned.insert(chunk);
+    }
+    Collector::untrackIf([&owned](const Object& object)
+                         { return owned.count(chunkOf(&object)) > 0; });
+
+    while (chunks)
+    {
+        Chunk* chunk = chunks;
+        chunks       = chunk->next;
+        ::operator delete(chunk, std::align_val_t(chunkSize));
+    }
+}
+
+Pool& Pool::fallback()
+{
+    // Never destroyed, so objects released during static destruction can still be returned to it
+    static Pool* pool = new Pool();
+    return *pool;
+}
+
+void* Pool::allocate(size_t size)
+{
+    if (size == 0 || size > largestBlock)
+    {
+        return ::operator new(size);
+    }
+
+    Pool&        pool  = active();
+    const size_t index = sizeClass(size);
+    Chunk*       chunk = pool.available[index];
+    if (!chunk)
+    {
+        chunk = &pool.addChunk(index);
+    }
+
+    void* block;
+    if (chunk->freeList)
+    {
+        block           = chunk->freeList;
+        chunk->freeList = chunk->freeList->next;
+    }
+    else
+    {
+        block = chunk->unused;
+        chunk->unused += blockSize(index);
+    }
+    ++chunk->liveCount;
+
+    if (isFull(*chunk))
+    {
+        pool.makeUnavailable(*chunk);
+    }
+    return block;
+}
+
+void Pool::deallocate(void* block, size_t size)
+{
+    if (size == 0 || size > largestBlock)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    Chunk& chunk = *chunkOf(block);
+    Pool&  pool  = *chunk.owner;
+
+    auto* freed    = static_cast<FreeBlock*>(block);
+    freed->next    = chunk.freeList;
+    chunk.freeList = freed;
+    --chunk.liveCount;
+
+    if (!chunk.isAvailable)
+    {
+        pool.makeAvailable(chunk);
+    }
+    else if (chunk.liveCount == 0 && (chunk.previousAvailable || chunk.nextAvailable))
+    {
+        // Another chunk has room, so keeping this one would not save allocating a new one
+        pool.removeChunk(chunk);
+    }
+}
+
+Pool::Chunk& Pool::addChunk(size_t sizeClass)
+{
+    void*  memory = ::operator new(chunkSize, std::align_val_t(chunkSize));
+    Chunk* chunk  = new (memory) Chunk();
+
+    chunk->owner     = this;
+    chunk->sizeClass = static_cast<uint32_t>(sizeClass);
+    chunk->unused    = reinterpret_cast<std::byte*>(chunk + 1);
+
+    chunk->next = chunks;
+    if (chunks)
+    {
+        chunks->previous = chunk;
+    }
+    chunks = chunk;
+
+    makeAvailable(*chunk);
+    return *chunk;
+}
+
+void Pool::removeChunk(Chunk& chunk)
+{
+    makeUnavailable(chunk);
+
+    if (chunk.previous)
+    {
+        chunk.previous->next = chunk.next;
+    }
+    else
+    {
+        chunks = chunk.next;
+    }
+    if (chunk.next)
+    {
+        chunk.next->previous = chunk.previous;
+    }
+
+    ::operator delete(&chunk, std::align_val_t(chunkSize));
+}
+
+void Pool::makeAvailable(Chunk& chunk)
+{
+    Chunk*& first = available[chunk.sizeClass];
+
+    chunk.isAvailable       = true;
+    chunk.previousAvailable = nullptr;
+    chunk.nextAvailable     = first;
+    if (first)
+    {
+        first->previousAvailable = &chunk;
+    }
+    first = &chunk;
+}
+
+void Pool::makeUnavailable(Chunk& chunk)
+{
+    if (chunk.previousAvailable)
+    {
+        chunk.previousAvailable->nextAvailable = chunk.nextAvailable;
+    }
+    else
+    {
+        available[chunk.sizeClass] = chunk.nextAvailable;
+    }
+    if (chunk.nextAvailable)
+    {
+        chunk.nextAvailable->previousAvailable = chunk.previousAvailable;
+    }
+    chunk.isAvailable = false;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Size-class free-list allocator for the small runtime objects the engines create and destroy at a
+// high rate: strings, Cells, functions and closure Environments. Each size class carves blocks
+// out of large chunks and keeps freed blocks on a free list for reuse, so allocating is usually a
+// pop from a list instead of a call to malloc, and objects of the same kind sit close together.
+//
+// Objects are allocated from the active pool, which a Pool::Scope sets for the run of a program
+// (a process-wide pool serves allocations made outside any scope). A chunk is aligned to its size
+// and starts with a header naming the pool that owns it, so a block is always returned to its own
+// pool. A chunk is released once all of its blocks are free, unless it is the only chunk of its
+// size class with room left, and the rest are released with the pool, which must outlive every
+// object allocated from it. Cycles are only freed by the Collector, so a pool runs a last full
+// collection before releasing its chunks. Larger requests go to the global operator new. Like the
+// rest of the runtime, pools are single-threaded.
+class Pool
+{
+   public:
+    Pool() = default;
+    ~Pool();
+
+    Pool(const Pool&)            = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    static void* allocate(size_t size);
+    static void  deallocate(void* block, size_t size);
+
+    // The pool objects are allocated from
+    static Pool& active() { return current ? *current : fallback(); }
+
+    // Makes a pool the active one for its lifetime
+    class Scope
+    {
+       public:
+        explicit Scope(Pool& pool) : previous(current) { current = &pool; }
+        ~Scope() { current = previous; }
+
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        Pool* previous;
+    };
+
+   private:
+    // Blocks are a multiple of `granularity`, up to `largestBlock` bytes
+    static constexpr size_t granularity  = 16;
+    static constexpr size_t largestBlock = 128;
+    static constexpr size_t classCount   = largestBlock / granularity;
+
+    static constexpr size_t chunkSize = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // Header at the start of each chunk. Blocks follow it; those from `unused` on were never handed
+    // out.
+    struct alignas(granularity) Chunk
+    {
+        Pool*      owner;
+        uint32_t   sizeClass;
+        uint32_t   liveCount = 0;
+        FreeBlock* freeList  = nullptr;
+        std::byte* unused;
+
+        // Neighbours among all of the owner's chunks
+        Chunk* previous = nullptr;
+        Chunk* next     = nullptr;
+
+        // Neighbours among the owner's chunks of this size class that have room left
+        bool   isAvailable       = false;
+        Chunk* previousAvailable = nullptr;
+        Chunk* nextAvailable     = nullptr;
+    };
+
+    static inline Pool* current = nullptr;
+
+    // Chunks with room left, by size class; blocks are taken from the first
+    Chunk* available[classCount] = {};
+
+    // Every chunk, released with the pool
+    Chunk* chunks = nullptr;
+
+    static Pool& fallback();
+
+    static size_t sizeClass(size_t size) { return (size - 1) / granularity; }
+    static size_t blockSize(size_t sizeClass) { return (sizeClass + 1) * granularity; }
+
+    static Chunk* chunkOf(const void* block)
+    {
+        return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(block) & ~(chunkSize - 1));
+    }
+
+    static bool isFull(const Chunk& chunk)
+    {
+        const auto* end = reinterpret_cast<const std::byte*>(&chunk) + chunkSize;
+        return !chunk.freeList && chunk.unused + blockSize(chunk.sizeClass) > end;
+    }
+
+    Chunk& addChunk(size_t sizeClass);
+    void   removeChunk(Chunk& chunk);
+
+    void makeAvailable(Chunk& chunk);
+    void makeUnavailable(Chunk& chunk);
+};
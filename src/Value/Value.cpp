@@ -0,0 +1,38 @@
+#include "Value.h"
+
+#include <iostream>
+
+#include "NumberPrinting.h"
+
+bool Value::isTruthy() const
+{
+    if (isNumber())
+    {
+        return asNumber() != 0;  // Zero is false, nonzero is true
+    }
+    if (isObject())
+    {
+        return asObject()->isTruthy();
+    }
+    return bits == TRUE_BITS;
+}
+
+void Value::print() const
+{
+    if (isNumber())
+    {
+        printNumber(asNumber());
+        return;
+    }
+    if (isObject())
+    {
+        asObject()->print();
+        return;
+    }
+    if (isBool())
+    {
+        std::cout << (asBool() ? "true" : "false") << std::endl;
+        return;
+    }
+    std::cout << "nil" << std::endl;
+}
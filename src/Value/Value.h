@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "Object.h"
+
+// Dynamic type of a Value, cheap to compute from its tag bits. The order is used to index dispatch
+// tables, so new types must be appended before Count.
+enum class ValueType : uint8_t
+{
+    Number,
+    Nil,
+    Bool,
+    String,
+    Callable,
+
+    Count
+};
+
+// A 64-bit NaN-boxed runtime value.
+//
+// Any bit pattern that is not a quiet NaN with our tag bits set is a plain double. Nil and the two
+// booleans are encoded as distinct quiet NaNs, and heap objects (strings, callables) are encoded as
+// a quiet NaN with the sign bit set and the object pointer in the low 48 bits. Only the object case
+// touches a reference count when a Value is copied or destroyed.
+class Value
+{
+   public:
+    Value() : bits(NIL_BITS) {}
+    explicit Value(bool value) : bits(value ? TRUE_BITS : FALSE_BITS) {}
+    explicit Value(double value) { std::memcpy(&bits, &value, sizeof(double)); }
+
+    // Takes a reference to `object`; the object is destroyed once the last Value referring to it
+    // goes away.
+    explicit Value(Object* object) : bits(SIGN_BIT | QNAN | reinterpret_cast<uintptr_t>(object))
+    {
+        object->retain();
+    }
+
+    explicit Value(std::string value) : Value(new StringObject(std::move(value))) {}
+
+    Value(const Value& other) : bits(other.bits)
+    {
+        if (isObject())
+        {
+            asObject()->retain();
+        }
+    }
+
+    Value(Value&& other) noexcept : bits(other.bits) { other.bits = NIL_BITS; }
+
+    Value& operator=(const Value& other)
+    {
+        Value copy(other);
+        std::swap(bits, copy.bits);
+        return *this;
+    }
+
+    Value& operator=(Value&& other) noexcept
+    {
+        std::swap(bits, other.bits);
+        return *this;
+    }
+
+    ~Value()
+    {
+        if (isObject())
+        {
+            asObject()->release();
+        }
+    }
+
+    // Marks a local whose declaration has not run yet, see VariableLocation::fallback. Programs
+    // never see it.
+    static Value undefined()
+    {
+        Value value;
+        value.bits = UNDEFINED_BITS;
+        return value;
+    }
+
+    bool isNil() const { return bits == NIL_BITS; }
+    bool isUndefined() const { return bits == UNDEFINED_BITS; }
+    bool isBool() const { return (bits | 1) == TRUE_BITS; }
+    bool isNumber() const { return (bits & QNAN) != QNAN; }
+    bool isObject() const { return (bits & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT); }
+    bool isString() const { return isObject() && asObject()->getKind() == Object::Kind::String; }
+    bool isCallable() const
+    {
+        return isObject() && asObject()->getKind() == Object::Kind::Callable;
+    }
+
+    ValueType type() const
+    {
+        if (isNumber())
+        {
+            return ValueType::Number;
+        }
+        if (isObject())
+        {
+            return asObject()->getKind() == Object::Kind::String ? ValueType::String
+                                                                  : ValueType::Callable;
+        }
+        return bits == NIL_BITS ? ValueType::Nil : ValueType::Bool;
+    }
+
+    // Single test for the common case of an operation on two numbers
+    static bool areNumbers(const Value& lhs, const Value& rhs)
+    {
+        return ((lhs.bits & QNAN) != QNAN) & ((rhs.bits & QNAN) != QNAN);
+    }
+
+    bool   asBool() const { return bits == TRUE_BITS; }
+    double asNumber() const
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+    Object* asObject() const { return reinterpret_cast<Object*>(bits & ~(SIGN_BIT | QNAN)); }
+
+    // The boxed representation, for generated code that compares values by identity
+    uint64_t getBits() const { return bits; }
+
+    const std::string& asString() const
+    {
+        return static_cast<StringObject*>(asObject())->getValue();
+    }
+
+    // Nil and false are falsy, and so is the number zero; strings are always truthy.
+    bool isTruthy() const;
+
+    void print() const;
+
+   private:
+    static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+    static constexpr uint64_t QNAN     = 0x7ffc000000000000;
+
+    static constexpr uint64_t NIL_BITS   = QNAN | 1;
+    static constexpr uint64_t FALSE_BITS = QNAN | 2;
+    static constexpr uint64_t TRUE_BITS  = QNAN | 3;
+
+    static constexpr uint64_t UNDEFINED_BITS = QNAN | 4;
+
+    uint64_t bits;
+};
@@ -1,15 +1,25 @@
+#include <fstream>
 #include <iostream>
-#include <memory>
+#include <utility>
 
+#include "Ast/Ast.h"
+#include "ClosureCompiler/ClosureCompiler.h"
 #include "CommandLineArgs/CommandLineArgs.h"
 #include "Environment/Environment.h"
 #include "Evaluator/Evaluator.h"
 #include "Evaluator/EvaluatorError.h"
+#include "Optimizer/Optimizer.h"
 #include "Parser/Parser.h"
 #include "Parser/ParserError.h"
 #include "Printer/Printer.h"
+#include "Resolver/Resolver.h"
 #include "Scanner/Scanner.h"
 #include "Statement/Statement.h"
+#include "Transpiler/Transpiler.h"
+#include "VM/Compiler.h"
+#include "VM/VM.h"
+#include "Value/ConstantPool.h"
+#include "Value/Pool.h"
 
 int main(int argc, char* argv[])
 {
@@ -17,6 +27,11 @@ int main(int argc, char* argv[])
     std::cout << std::unitbuf;
     std::cerr << std::unitbuf;
 
+    // Runtime objects of this run are allocated from `pool`, which is declared first so it outlives
+    // all of them and returns their memory when the run ends
+    Pool        pool;
+    Pool::Scope poolScope(pool);
+
     CommandLineArgs cmdProcessor(argc, argv);
 
     if (!cmdProcessor.validateArgs())
@@ -44,31 +59,95 @@ int main(int argc, char* argv[])
     // Step 2: Parse the tokens into statements
     try
     {
-        Parser parser(std::move(tokens));
-        auto   statements = parser.parse();
+        ConstantPool constants;
+
+        // The tokens are released once parsed
+        Ast ast = Parser(std::move(tokens), constants).parse();
 
         // Step 3: Handle commands
         if (command == "parse")
         {
-            Printer printer;
-            for (const auto& statement : statements)
+            Printer printer(ast);
+            for (StatementId statement : ast.getStatements())
             {
-                auto exprStmt = dynamic_cast<ExpressionStatement*>(statement.get());
-                if (exprStmt)
+                if (statement.kind() == StatementKind::Expression)
                 {
-                    exprStmt->getExpression()->accept(printer);
+                    visit(printer, ast, ast.get<ExpressionStatement>(statement).getExpression());
                 }
             }
             return 0;
         }
 
-        std::shared_ptr<Environment> globalEnv = std::make_shared<Environment>();
-        globalEnv->initializeGlobalScope();
+        // Optimize the AST before the Resolver annotates it
+        const bool dump = cmdProcessor.hasOption("dump-optimized");
+        if (dump || cmdProcessor.hasOption("O"))
+        {
+            // The optimized program is built in an Ast of its own, which then replaces the parsed
+            // one, so the nodes the Optimizer dropped do not stay for the whole run
+            Optimizer optimizer(constants);
+            ast = optimizer.optimize(ast);
+        }
+        if (dump)
+        {
+            Printer printer(ast, Printer::Mode::Program);
+            printer.print();
+            return 0;
+        }
+
+        GlobalEnvironment globals;
+        globals.initializeGlobalScope();
 
-        Evaluator evaluator;
-        for (const auto& statement : statements)
+        Resolver resolver(globals);
+        resolver.resolve(ast);
+
+        if (command == "compile")
+        {
+            Transpiler    transpiler;
+            std::ofstream output(cmdProcessor.getOutputPath());
+            output << transpiler.transpile(ast, globals, resolver.getFrameSize());
+            if (!output)
+            {
+                std::cerr << "Could not write " << cmdProcessor.getOutputPath() << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        if (cmdProcessor.getOption("engine", "tree") == "vm")
         {
-            statement->accept(evaluator, globalEnv.get());
+            Compiler compiler;
+            Program  program = compiler.compile(ast, resolver.getFrameSize());
+            VM       vm(globals, program);
+            vm.run();
+            return 0;
+        }
+
+        if (cmdProcessor.getOption("engine", "tree") == "closure")
+        {
+            ClosureCompiler  compiler;
+            ExecutionContext context(globals, resolver.getFrameSize());
+            for (const auto& statement : compiler.compile(ast))
+            {
+                if (statement(context) == Completion::Return)
+                {
+                    break;
+                }
+            }
+            return 0;
+        }
+
+        Evaluator evaluator(globals, ast, resolver.getFrameSize());
+        if (cmdProcessor.hasOption("jit"))
+        {
+            evaluator.enableJit();
+        }
+        for (StatementId statement : ast.getStatements())
+        {
+            // A `return` outside any function ends the script
+            if (visit(evaluator, ast, statement) == Completion::Return)
+            {
+                break;
+            }
         }
     }
     catch (const ParserError& e)
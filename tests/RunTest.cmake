@@ -0,0 +1,51 @@
+# Runs one test program and compares its output with the expected one.
+#
+# Usage: cmake -DINTERPRETER=<binary> -DSCRIPT=<name>.lox [-DCOMMAND=<command>]
+#              [-DOPTIONS=<options>] [-DCXX=<compiler> -DPROGRAM=<path>] -P RunTest.cmake
+#
+# <name>.expected holds what the command, `run` by default, prints to stdout and stderr, followed
+# by a line with its exit status. Every engine must produce exactly the same.
+#
+# With `compile`, the program is translated to PROGRAM.cpp, built into PROGRAM with CXX and run,
+# so the translation is held to the same output. A program that does not translate is compared
+# by what the compile command prints.
+
+if(NOT COMMAND)
+    set(COMMAND run)
+endif()
+
+separate_arguments(options UNIX_COMMAND "${OPTIONS}")
+if("${COMMAND}" STREQUAL "compile")
+    execute_process(COMMAND ${INTERPRETER} compile ${options} ${SCRIPT} ${PROGRAM}.cpp
+                    OUTPUT_VARIABLE output
+                    ERROR_VARIABLE output
+                    RESULT_VARIABLE status)
+    if(status EQUAL 0)
+        execute_process(COMMAND ${CXX} -std=c++20 -O2 ${PROGRAM}.cpp -o ${PROGRAM}
+                        OUTPUT_VARIABLE buildOutput
+                        ERROR_VARIABLE buildOutput
+                        RESULT_VARIABLE buildStatus)
+        if(NOT buildStatus EQUAL 0)
+            message(FATAL_ERROR "Translation of ${SCRIPT} with '${OPTIONS}' does not build.\n"
+                                "${buildOutput}")
+        endif()
+        execute_process(COMMAND ${PROGRAM}
+                        OUTPUT_VARIABLE output
+                        ERROR_VARIABLE output
+                        RESULT_VARIABLE status)
+    endif()
+else()
+    execute_process(COMMAND ${INTERPRETER} ${COMMAND} ${options} ${SCRIPT}
+                    OUTPUT_VARIABLE output
+                    ERROR_VARIABLE output
+                    RESULT_VARIABLE status)
+endif()
+string(APPEND output "exit=${status}\n")
+
+string(REGEX REPLACE "\\.lox$" ".expected" expectedFile "${SCRIPT}")
+file(READ ${expectedFile} expected)
+
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "Output of ${SCRIPT} with '${OPTIONS}' differs.\n"
+                        "Expected:\n${expected}\nActual:\n${output}")
+endif()